@@ -30,16 +30,17 @@ int main()
     std::cout << vmp::solveByOpportunityAwareEfficiency(general).getHostCount() << std::endl;
     std::cout << vmp::solveByOverloadAndRemove(general).getHostCount() << std::endl;
 
-    // Using the tree solver with an intermediate solver which iterates over an std::unordered_set
+    // Using the tree solver with an intermediate solver which iterates over an std::vector
     // collection of guests
-    using SetGuestIt = std::unordered_set<std::shared_ptr<const vmp::Guest>>::iterator;
+    using VectorGuestIt = std::vector<std::shared_ptr<const vmp::Guest>>::iterator;
 
-    std::cout << vmp::solveByTree<SetGuestIt>(tree, vmp::proceedByFirstFit).getHostCount()
-              << std::endl;
-    std::cout << vmp::solveByTree<SetGuestIt>(tree, vmp::proceedByOverloadAndRemove).getHostCount()
+    std::cout << vmp::solveByTree<VectorGuestIt>(tree, vmp::proceedByFirstFit).getHostCount()
               << std::endl;
+    std::cout
+        << vmp::solveByTree<VectorGuestIt>(tree, vmp::proceedByOverloadAndRemove).getHostCount()
+        << std::endl;
 
-    // Using the general solvers on an instance ordered by tree insertion
+    // Using the general solvers on the guests of the tree in depth-first order
     std::cout << vmp::solveByOpportunityAwareEfficiency(tree).getHostCount() << std::endl;
     std::cout << vmp::solveByOverloadAndRemove(tree).getHostCount() << std::endl;
 }
@@ -1,11 +1,14 @@
 #include <vmp_clustertreeinstance.h>
 
 #include <cassert>
+#include <ranges>
+#include <stack>
 
 namespace vmp
 {
 
-ClusterTreeInstance::ClusterTreeInstance(const size_t capacity) : capacity(capacity)
+ClusterTreeInstance::ClusterTreeInstance(const size_t capacity)
+    : guestsAreStale(true), capacity(capacity)
 {
     clusters = std::vector<Cluster>(ROOT_CLUSTER + 1);
     clusters[ROOT_CLUSTER] = Cluster(ROOT_CLUSTER, { 0 });
@@ -51,6 +54,7 @@ size_t ClusterTreeInstance::addLeaf(const std::vector<size_t> &parents,
     nodes.emplace_back(parents, pages, guest, newCluster);
     clusters[newCluster].nodes.push_back(newNode);
     this->leaves.push_back(newNode);
+    guestsAreStale = true;
 
     for (const size_t parent : parents) {
         nodes[parent].children.push_back(newNode);
@@ -79,13 +83,41 @@ size_t ClusterTreeInstance::getRootCluster()
     return ROOT_CLUSTER;
 }
 
-std::vector<std::shared_ptr<const Guest>> ClusterTreeInstance::getGuests() const
+void ClusterTreeInstance::makeGuestsIfStale() const
 {
-    std::vector<std::shared_ptr<const Guest>> guests;
+    if (!guestsAreStale) {
+        return;
+    }
+
+    guests.clear();
     guests.reserve(leaves.size());
-    for (const auto &leaf : leaves) {
-        guests.emplace_back(getNodeGuest(leaf));
+
+    // Each leaf is alone in its cluster, so visiting the clusters depth-first orders the leaves too
+    std::stack<size_t> clustersToVisit;
+    clustersToVisit.push(ROOT_CLUSTER);
+
+    while (!clustersToVisit.empty()) {
+        const size_t cluster = clustersToVisit.top();
+        clustersToVisit.pop();
+
+        // The root cluster only stands in for the node 0, which has a cluster of its own
+        if (cluster != ROOT_CLUSTER && clusterIsLeaf(cluster)) {
+            guests.push_back(getNodeGuest(clusters[cluster].nodes[0]));
+        }
+
+        // Pushed in reverse, so that children are visited in the order they were added
+        for (const size_t child : std::views::reverse(clusters[cluster].children)) {
+            clustersToVisit.push(child);
+        }
     }
+    assert(guests.size() == leaves.size());
+
+    guestsAreStale = false;
+}
+
+const std::vector<std::shared_ptr<const Guest>> &ClusterTreeInstance::getGuests() const
+{
+    makeGuestsIfStale();
     return guests;
 }
 
@@ -139,6 +171,11 @@ const std::shared_ptr<const Guest> &ClusterTreeInstance::getNodeGuest(const size
     return nodes[node].guest;
 }
 
+size_t ClusterTreeInstance::getNodeCluster(const size_t node) const
+{
+    return nodes[node].cluster;
+}
+
 bool ClusterTreeInstance::nodeIsLeaf(const size_t node) const
 {
     return nodes[node].guest != nullptr;
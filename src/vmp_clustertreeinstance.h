@@ -29,6 +29,7 @@ class ClusterTreeInstance
     [[nodiscard]] const std::vector<size_t> &getNodeChildren(size_t node) const;
     [[nodiscard]] const std::unordered_set<int> &getNodePages(size_t node) const;
     [[nodiscard]] const std::shared_ptr<const Guest> &getNodeGuest(size_t node) const;
+    [[nodiscard]] size_t getNodeCluster(size_t node) const;
     [[nodiscard]] bool nodeIsLeaf(size_t node) const;
     [[nodiscard]] size_t getNodeCount() const;
     [[nodiscard]] size_t nodeCountOf(size_t cluster) const;
@@ -37,7 +38,16 @@ class ClusterTreeInstance
     [[nodiscard]] size_t getClusterCount() const;
     [[nodiscard]] static size_t getRootCluster();
 
-    [[nodiscard]] std::vector<std::shared_ptr<const Guest>> getGuests() const;
+    /**
+     * The guests of the leaves, in depth-first order of the cluster tree, so that guests under the
+     * same clusters are next to each other
+     *
+     * The first call after leaves are added makes the guests, so it is not thread-safe: threads
+     * sharing an instance must not call it until it has been called once since the last change.
+     *
+     * @return the guests, valid until the instance is next changed
+     */
+    [[nodiscard]] const std::vector<std::shared_ptr<const Guest>> &getGuests() const;
     [[nodiscard]] size_t getCapacity() const;
 
     explicit ClusterTreeInstance(size_t capacity);
@@ -82,11 +92,16 @@ class ClusterTreeInstance
 
     [[nodiscard]] bool checkNodesAreInCluster(const std::vector<size_t> &nodes,
                                               size_t cluster) const;
+    void makeGuestsIfStale() const;
 
     std::vector<Node> nodes;
     std::vector<size_t> leaves;
     std::vector<Cluster> clusters;
 
+    // The guests of the leaves in depth-first order, made on first use after the instance has grown
+    mutable std::vector<std::shared_ptr<const Guest>> guests;
+    mutable bool guestsAreStale;
+
     const size_t capacity;
 };
 
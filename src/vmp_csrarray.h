@@ -0,0 +1,62 @@
+#ifndef VMP_CSRARRAY_H
+#define VMP_CSRARRAY_H
+
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * Rows of values stored back to back in one array, in compressed sparse row (CSR) form: row i is
+ * `values[offsets[i]...offsets[i + 1])`. Rows are appended in order and never changed. Offsets are
+ * 32-bit, so the rows may hold at most `UINT32_MAX` values in all.
+ *
+ * @tparam T the type of the values
+ */
+template <typename T>
+class CsrArray
+{
+  public:
+    CsrArray() : offsets{ 0 } {}
+
+    /**
+     * Appends a row
+     *
+     * @param row the values of the row, each converted to `T`
+     * @throws std::length_error if the rows would then hold more than `UINT32_MAX` values, in
+     * which case the row is not appended
+     */
+    template <std::ranges::input_range Row>
+    void pushRow(const Row &row)
+    {
+        const size_t rowBegin = values.size();
+        for (const auto &value : row) {
+            values.push_back(static_cast<T>(value));
+        }
+        if (values.size() > std::numeric_limits<uint32_t>::max()) {
+            values.resize(rowBegin);
+            throw std::length_error("CsrArray holds more values than its 32-bit offsets index");
+        }
+        offsets.push_back(static_cast<uint32_t>(values.size()));
+    }
+
+    [[nodiscard]] std::span<const T> operator[](const size_t row) const
+    {
+        return std::span(values).subspan(offsets[row], offsets[row + 1] - offsets[row]);
+    }
+
+    [[nodiscard]] size_t getRowCount() const { return offsets.size() - 1; }
+
+  private:
+    std::vector<uint32_t> offsets;
+    std::vector<T> values;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_CSRARRAY_H
@@ -0,0 +1,114 @@
+#include <vmp_decomposition.h>
+
+#include <vmp_solverutils.h>
+#include <vmp_threadpool.h>
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+
+namespace vmp
+{
+
+std::vector<GeneralInstance> decomposeIntoComponents(const GeneralInstance &instance)
+{
+    const auto &guests = instance.getGuests();
+
+    // Guests sharing a page are joined through the first guest seen with it
+    DisjointSets components(guests.size());
+    std::unordered_map<int, size_t> firstGuestsOfPages;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        for (const int page : guests[guest]->pages) {
+            const auto [it, inserted] = firstGuestsOfPages.try_emplace(page, guest);
+            if (!inserted) {
+                components.unite(guest, it->second);
+            }
+        }
+    }
+
+    std::vector<std::vector<std::shared_ptr<const Guest>>> componentGuests;
+    std::unordered_map<size_t, size_t> componentIndices;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        const auto [it, inserted] =
+            componentIndices.try_emplace(components.find(guest), componentGuests.size());
+        if (inserted) {
+            componentGuests.emplace_back();
+        }
+        componentGuests[it->second].push_back(guests[guest]);
+    }
+
+    std::vector<GeneralInstance> result;
+    result.reserve(componentGuests.size());
+    for (const auto &component : componentGuests) {
+        result.emplace_back(instance.getCapacity(), component);
+    }
+    return result;
+}
+
+void combineHosts(std::vector<std::shared_ptr<Host>> &hosts)
+{
+    std::vector<size_t> order(hosts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::greater{}, [&](const size_t host) {
+        return hosts[host]->getUniquePageCount();
+    });
+
+    // The hosts kept so far with room left, by (room left, index)
+    std::set<std::pair<size_t, size_t>> open;
+    const auto findRoom = [&](const size_t host) {
+        const size_t used = hosts[host]->getUniquePageCount();
+        const size_t capacity = hosts[host]->getCapacity();
+        return used < capacity ? capacity - used : 0;
+    };
+
+    for (const size_t host : order) {
+        const auto &guests = hosts[host]->getGuests();
+
+        const auto it = open.lower_bound({ hosts[host]->getUniquePageCount(), 0 });
+        if (it == open.end()) {
+            if (findRoom(host) > 0) {
+                open.emplace(findRoom(host), host);
+            }
+            continue;
+        }
+
+        const size_t target = it->second;
+        open.erase(it);
+
+        hosts[target]->addGuests(guests.begin(), guests.end());
+        hosts[host].reset();
+
+        if (findRoom(target) > 0) {
+            open.emplace(findRoom(target), target);
+        }
+    }
+    std::erase(hosts, nullptr);
+}
+
+Packing solveByComponents(const GeneralInstance &instance,
+                          const std::function<Packing(const GeneralInstance &)> &solver,
+                          const size_t threadCount)
+{
+    const auto components = decomposeIntoComponents(instance);
+
+    std::vector<std::vector<std::shared_ptr<Host>>> componentHosts(components.size());
+    WorkStealingPool pool(threadCount);
+    for (size_t i = 0; i < components.size(); ++i) {
+        pool.submit([&, i] {
+            Packing packing = solver(components[i]);
+            componentHosts[i] = std::move(packing.getHosts());
+        });
+    }
+    pool.wait();
+
+    std::vector<std::shared_ptr<Host>> hosts;
+    for (auto &packed : componentHosts) {
+        std::ranges::move(packed, std::back_inserter(hosts));
+    }
+    combineHosts(hosts);
+
+    return Packing(hosts);
+}
+
+}  // namespace vmp
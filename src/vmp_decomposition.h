@@ -0,0 +1,53 @@
+#ifndef VMP_DECOMPOSITION_H
+#define VMP_DECOMPOSITION_H
+
+#include <vmp_generalinstance.h>
+#include <vmp_host.h>
+#include <vmp_packing.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * Splits an instance into the connected components of its guest-page graph, i.e. the largest sets
+ * of guests that share pages, directly or through other guests. No two components share a page, so
+ * each can be packed on its own.
+ *
+ * @param instance the instance to split
+ * @return an instance with the same capacity for each component, in the order of their first
+ *         guests, each holding its guests in the order given
+ */
+std::vector<GeneralInstance> decomposeIntoComponents(const GeneralInstance &instance);
+
+/**
+ * Combines partly used hosts by Best Fit Decreasing on their page counts: from the most used, each
+ * host's guests are moved onto the host with the least room left that still has room for all of
+ * its pages. Pages shared between the two hosts are counted twice, so this is exact for hosts
+ * packed from different components, and never overfills a host otherwise.
+ *
+ * @param hosts the hosts to combine, from which emptied hosts are removed
+ */
+void combineHosts(std::vector<std::shared_ptr<Host>> &hosts);
+
+/**
+ * Solves VM-PACK by packing each connected component of the instance on its own, concurrently, and
+ * then combining the partly used hosts of different components with `combineHosts`. The solver
+ * only ever sees one component, which keeps its working set small on clustered instances.
+ *
+ * @param instance the instance to solve
+ * @param solver the solver with which to pack each component, e.g. `solveByFirstFit`, which must
+ *        be safe to run on different instances concurrently
+ * @param threadCount the number of worker threads to use. Defaults to 1.
+ * @return a valid packing, if the solver gives valid packings
+ */
+Packing solveByComponents(const GeneralInstance &instance,
+                          const std::function<Packing(const GeneralInstance &)> &solver,
+                          size_t threadCount = 1);
+
+}  // namespace vmp
+
+#endif  // VMP_DECOMPOSITION_H
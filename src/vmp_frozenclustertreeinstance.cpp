@@ -0,0 +1,110 @@
+#include <vmp_frozenclustertreeinstance.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace vmp
+{
+
+FrozenClusterTreeInstance::FrozenClusterTreeInstance(const ClusterTreeInstance &instance)
+    : leaves(instance.getLeafNodes().begin(), instance.getLeafNodes().end()),
+      capacity(instance.getCapacity())
+{
+    assert(instance.getNodeCount() <= std::numeric_limits<uint32_t>::max());
+    assert(instance.getClusterCount() <= std::numeric_limits<uint32_t>::max());
+
+    clusterParents.reserve(instance.getClusterCount());
+    for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
+        clusterNodes.pushRow(instance.getClusterNodes(cluster));
+        clusterChildren.pushRow(instance.getClusterChildren(cluster));
+        clusterParents.push_back(static_cast<uint32_t>(instance.getClusterParent(cluster)));
+    }
+
+    nodeGuests.reserve(instance.getNodeCount());
+    nodeClusters.reserve(instance.getNodeCount());
+    for (size_t node = 0; node < instance.getNodeCount(); ++node) {
+        std::vector<int> pages(instance.getNodePages(node).begin(),
+                               instance.getNodePages(node).end());
+        std::ranges::sort(pages);
+
+        nodeParents.pushRow(instance.getNodeParents(node));
+        nodeChildren.pushRow(instance.getNodeChildren(node));
+        nodePages.pushRow(pages);
+        nodeGuests.push_back(instance.getNodeGuest(node));
+        nodeClusters.push_back(static_cast<uint32_t>(instance.getNodeCluster(node)));
+    }
+}
+
+std::span<const uint32_t> FrozenClusterTreeInstance::getClusterNodes(const size_t cluster) const
+{
+    return clusterNodes[cluster];
+}
+
+std::span<const uint32_t> FrozenClusterTreeInstance::getClusterChildren(const size_t cluster) const
+{
+    return clusterChildren[cluster];
+}
+
+size_t FrozenClusterTreeInstance::getClusterParent(const size_t cluster) const
+{
+    return clusterParents[cluster];
+}
+
+bool FrozenClusterTreeInstance::clusterIsLeaf(const size_t cluster) const
+{
+    const auto nodes = getClusterNodes(cluster);
+    return nodes.size() == 1 && nodeIsLeaf(nodes[0]);
+}
+
+std::span<const uint32_t> FrozenClusterTreeInstance::getNodeParents(const size_t node) const
+{
+    return nodeParents[node];
+}
+
+std::span<const uint32_t> FrozenClusterTreeInstance::getNodeChildren(const size_t node) const
+{
+    return nodeChildren[node];
+}
+
+std::span<const int> FrozenClusterTreeInstance::getNodePages(const size_t node) const
+{
+    return nodePages[node];
+}
+
+const std::shared_ptr<const Guest> &FrozenClusterTreeInstance::getNodeGuest(const size_t node) const
+{
+    return nodeGuests[node];
+}
+
+size_t FrozenClusterTreeInstance::getNodeCluster(const size_t node) const
+{
+    return nodeClusters[node];
+}
+
+bool FrozenClusterTreeInstance::nodeIsLeaf(const size_t node) const
+{
+    return nodeGuests[node] != nullptr;
+}
+
+size_t FrozenClusterTreeInstance::getNodeCount() const
+{
+    return nodeGuests.size();
+}
+
+std::span<const uint32_t> FrozenClusterTreeInstance::getLeafNodes() const
+{
+    return leaves;
+}
+
+size_t FrozenClusterTreeInstance::getClusterCount() const
+{
+    return clusterParents.size();
+}
+
+size_t FrozenClusterTreeInstance::getCapacity() const
+{
+    return capacity;
+}
+
+}  // namespace vmp
@@ -0,0 +1,56 @@
+#ifndef VMP_FROZENCLUSTERTREEINSTANCE_H
+#define VMP_FROZENCLUSTERTREEINSTANCE_H
+
+#include <vmp_clustertreeinstance.h>
+#include <vmp_csrarray.h>
+
+namespace vmp
+{
+
+/**
+ * A read-only snapshot of a `ClusterTreeInstance`, with the nodes and children of every cluster
+ * and the parents, children and pages of every node in shared CSR arrays indexed by 32-bit
+ * indices, so that the DP walks contiguous memory rather than a vector or hash set per node.
+ * Node and cluster indices are those of the source instance, and each node's pages are sorted.
+ */
+class FrozenClusterTreeInstance
+{
+  public:
+    explicit FrozenClusterTreeInstance(const ClusterTreeInstance &instance);
+
+    [[nodiscard]] std::span<const uint32_t> getClusterNodes(size_t cluster) const;
+    [[nodiscard]] std::span<const uint32_t> getClusterChildren(size_t cluster) const;
+    [[nodiscard]] size_t getClusterParent(size_t cluster) const;
+    [[nodiscard]] bool clusterIsLeaf(size_t cluster) const;
+
+    [[nodiscard]] std::span<const uint32_t> getNodeParents(size_t node) const;
+    [[nodiscard]] std::span<const uint32_t> getNodeChildren(size_t node) const;
+    [[nodiscard]] std::span<const int> getNodePages(size_t node) const;
+    [[nodiscard]] const std::shared_ptr<const Guest> &getNodeGuest(size_t node) const;
+    [[nodiscard]] size_t getNodeCluster(size_t node) const;
+    [[nodiscard]] bool nodeIsLeaf(size_t node) const;
+    [[nodiscard]] size_t getNodeCount() const;
+
+    [[nodiscard]] std::span<const uint32_t> getLeafNodes() const;
+    [[nodiscard]] size_t getClusterCount() const;
+    [[nodiscard]] size_t getCapacity() const;
+
+  private:
+    CsrArray<uint32_t> clusterNodes;
+    CsrArray<uint32_t> clusterChildren;
+    std::vector<uint32_t> clusterParents;
+
+    CsrArray<uint32_t> nodeParents;
+    CsrArray<uint32_t> nodeChildren;
+    CsrArray<int> nodePages;
+    std::vector<std::shared_ptr<const Guest>> nodeGuests;
+    std::vector<uint32_t> nodeClusters;
+
+    std::vector<uint32_t> leaves;
+
+    size_t capacity;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_FROZENCLUSTERTREEINSTANCE_H
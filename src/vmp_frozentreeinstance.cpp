@@ -0,0 +1,82 @@
+#include <vmp_frozentreeinstance.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace vmp
+{
+
+FrozenTreeInstance::FrozenTreeInstance(const TreeInstance &instance)
+    : parents(instance.getNodeCount()),
+      existing(instance.getNodeCount()),
+      capacity(instance.getCapacity())
+{
+    assert(instance.getNodeCount() <= std::numeric_limits<uint32_t>::max());
+
+    // Only the nodes reachable from the root are still in the tree
+    nodesTopDown.push_back(TreeInstance::getRootNode());
+    existing[TreeInstance::getRootNode()] = true;
+
+    for (size_t i = 0; i < nodesTopDown.size(); ++i) {
+        const size_t node = nodesTopDown[i];
+        for (const size_t child : instance.getNodeChildren(node)) {
+            parents[child] = static_cast<uint32_t>(node);
+            existing[child] = true;
+            nodesTopDown.push_back(static_cast<uint32_t>(child));
+        }
+    }
+
+    // Rows go in node order, with empty ones for absent nodes
+    for (size_t node = 0; node < instance.getNodeCount(); ++node) {
+        if (!existing[node]) {
+            children.pushRow(std::span<const uint32_t>());
+            pages.pushRow(std::span<const int>());
+            continue;
+        }
+
+        std::vector<int> nodePages(instance.getNodePages(node).begin(),
+                                   instance.getNodePages(node).end());
+        std::ranges::sort(nodePages);
+
+        children.pushRow(instance.getNodeChildren(node));
+        pages.pushRow(nodePages);
+    }
+}
+
+std::span<const uint32_t> FrozenTreeInstance::getNodeChildren(const size_t node) const
+{
+    return children[node];
+}
+
+size_t FrozenTreeInstance::getNodeParent(const size_t node) const
+{
+    return parents[node];
+}
+
+std::span<const int> FrozenTreeInstance::getNodePages(const size_t node) const
+{
+    return pages[node];
+}
+
+bool FrozenTreeInstance::nodeExists(const size_t node) const
+{
+    return existing[node];
+}
+
+size_t FrozenTreeInstance::getNodeCount() const
+{
+    return parents.size();
+}
+
+size_t FrozenTreeInstance::getCapacity() const
+{
+    return capacity;
+}
+
+std::span<const uint32_t> FrozenTreeInstance::getNodesTopDown() const
+{
+    return nodesTopDown;
+}
+
+}  // namespace vmp
@@ -0,0 +1,44 @@
+#ifndef VMP_FROZENTREEINSTANCE_H
+#define VMP_FROZENTREEINSTANCE_H
+
+#include <vmp_csrarray.h>
+#include <vmp_treeinstance.h>
+
+namespace vmp
+{
+
+/**
+ * A read-only snapshot of the structure of a `TreeInstance`, with the children and pages of all
+ * nodes in shared CSR arrays indexed by 32-bit node indices, so that traversals touch contiguous
+ * memory. Node indices are those of the source instance; nodes removed from it are absent.
+ */
+class FrozenTreeInstance
+{
+  public:
+    explicit FrozenTreeInstance(const TreeInstance &instance);
+
+    [[nodiscard]] std::span<const uint32_t> getNodeChildren(size_t node) const;
+    [[nodiscard]] size_t getNodeParent(size_t node) const;
+    [[nodiscard]] std::span<const int> getNodePages(size_t node) const;
+    [[nodiscard]] bool nodeExists(size_t node) const;
+    [[nodiscard]] size_t getNodeCount() const;
+    [[nodiscard]] size_t getCapacity() const;
+
+    /**
+     * @return the nodes in breadth-first order from the root, so every node follows its parent
+     */
+    [[nodiscard]] std::span<const uint32_t> getNodesTopDown() const;
+
+  private:
+    CsrArray<uint32_t> children;
+    CsrArray<int> pages;
+    std::vector<uint32_t> parents;
+    std::vector<bool> existing;
+    std::vector<uint32_t> nodesTopDown;
+
+    size_t capacity;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_FROZENTREEINSTANCE_H
@@ -1,22 +1,60 @@
 #include <vmp_guest.h>
 
+#include <numeric>
 #include <ostream>
 #include <vmp_host.h>
 
 namespace vmp
 {
 
-Guest::Guest(const std::unordered_set<int> &pages) : pages(pages) {}
+Guest::Guest(const std::unordered_set<int> &pages) : pages(pages), uniquePageCount(pages.size())
+{
+    for (const int page : pages) {
+        sketch.addPage(page);
+    }
+}
+
+Guest::Guest(const std::unordered_set<int> &pages,
+             const std::unordered_map<int, size_t> &pageWeights)
+    : pages(pages), pageWeights(pageWeights),
+      uniquePageCount(std::accumulate(pages.begin(), pages.end(), size_t{ 0 },
+                                      [&](const size_t count, const int page) {
+                                          return count + getPageWeight(page);
+                                      }))
+{
+    for (const int page : pages) {
+        sketch.addPage(page, getPageWeight(page));
+    }
+}
 
 size_t Guest::getUniquePageCount() const
 {
-    return pages.size();
+    return uniquePageCount;
 }
 
 size_t Guest::countUniquePagesOn(const Host &host) const
 {
-    return std::ranges::count_if(pages,
-                                 [&](const int page) { return host.getPageFrequency(page); });
+    size_t count = 0;
+    for (const int page : pages) {
+        if (host.getPageFrequency(page)) {
+            count += getPageWeight(page);
+        }
+    }
+    return count;
+}
+
+size_t Guest::getPageWeight(const int page) const
+{
+    if (pageWeights.empty()) {
+        return 1;
+    }
+    const auto it = pageWeights.find(page);
+    return it != pageWeights.end() ? it->second : 1;
+}
+
+const PageSketch &Guest::getSketch() const
+{
+    return sketch;
 }
 
 std::ostream &operator<<(std::ostream &os, const Guest &guest)
@@ -1,7 +1,9 @@
 #ifndef SOLVERS_GUEST_H
 #define SOLVERS_GUEST_H
 
+#include <unordered_map>
 #include <unordered_set>
+#include <vmp_pagesketch.h>
 
 namespace vmp
 {
@@ -12,12 +14,34 @@ class Guest
 {
   public:
     explicit Guest(const std::unordered_set<int> &pages);
+
+    /**
+     * A guest whose pages each stand for a number of pages, e.g. a class of pages held by the same
+     * guests. Pages counts then sum the weights of the pages.
+     *
+     * @param pages the pages
+     * @param pageWeights the weight of each page. Pages without one weigh 1.
+     */
+    Guest(const std::unordered_set<int> &pages,
+          const std::unordered_map<int, size_t> &pageWeights);
+
     [[nodiscard]] size_t getUniquePageCount() const;
     [[nodiscard]] size_t countUniquePagesOn(const Host &host) const;
+    [[nodiscard]] size_t getPageWeight(int page) const;
+
+    /**
+     * @return a sketch of the guest's pages, each added with its weight
+     */
+    [[nodiscard]] const PageSketch &getSketch() const;
 
     const std::unordered_set<int> pages;
 
     friend std::ostream &operator<<(std::ostream &os, const Guest &guest);
+
+  private:
+    const std::unordered_map<int, size_t> pageWeights;
+    const size_t uniquePageCount;
+    PageSketch sketch;
 };
 
 }  // namespace vmp
@@ -6,14 +6,21 @@
 namespace vmp
 {
 
-Host::Host(const size_t capacity) : capacity(capacity) {}
+Host::Host(const size_t capacity) : uniquePageCount(0), sketchIsStale(true), capacity(capacity)
+{
+}
 
 bool Host::addGuest(const std::shared_ptr<const Guest> &guest)
 {
     for (const int page : guest->pages) {
-        ++pageFrequencies[page];
+        if (++pageFrequencies[page] == 1) {
+            uniquePageCount += guest->getPageWeight(page);
+        }
     }
     guests.insert(guest);
+    if (!sketchIsStale) {
+        unsketchedGuests.push_back(guest.get());
+    }
 
     return isOverfull();
 }
@@ -23,11 +30,16 @@ bool Host::removeGuest(const std::shared_ptr<const Guest> &guest)
     for (const int page : guest->pages) {
         if (--pageFrequencies[page] == 0) {
             pageFrequencies.erase(page);
+            uniquePageCount -= guest->getPageWeight(page);
         }
     }
 
     guests.erase(guest);
 
+    // A sketch cannot forget pages, so it is merged anew from the guests left when next needed
+    sketchIsStale = true;
+    unsketchedGuests.clear();
+
     return isOverfull();
 }
 
@@ -35,6 +47,10 @@ void Host::clearGuests()
 {
     guests.clear();
     pageFrequencies.clear();
+    uniquePageCount = 0;
+    sketch.clear();
+    unsketchedGuests.clear();
+    sketchIsStale = true;
 }
 
 size_t Host::getCapacity() const
@@ -52,6 +68,39 @@ bool Host::accommodatesGuest(const Guest &guest) const
     return countPagesWithGuest(guest) <= capacity;
 }
 
+PageScreening Host::screenGuest(const Guest &guest) const
+{
+    return screenSketch(guest.getSketch(), guest.getUniquePageCount());
+}
+
+PageScreening Host::screenSketch(const PageSketch &guestsSketch,
+                                 const size_t guestsPageCount) const
+{
+    if (uniquePageCount + guestsPageCount <= capacity) {
+        return SCREENING_FITS;
+    }
+
+    if (sketchIsStale) {
+        sketch.clear();
+        for (const auto &guest : guests) {
+            sketch.merge(guest->getSketch());
+        }
+        sketchIsStale = false;
+    }
+    else {
+        for (const Guest *guest : unsketchedGuests) {
+            sketch.merge(guest->getSketch());
+        }
+    }
+    unsketchedGuests.clear();
+
+    PageSketch unionSketch = sketch;
+    unionSketch.merge(guestsSketch);
+    const double threshold =
+        static_cast<double>(capacity) * (1 + SCREENING_MARGIN * PageSketch::getRelativeError());
+    return unionSketch.estimatePageCount() > threshold ? SCREENING_OVERFULL : SCREENING_UNCERTAIN;
+}
+
 const std::unordered_map<int, int> &Host::getPageFrequencies() const
 {
     return pageFrequencies;
@@ -64,7 +113,7 @@ size_t Host::getPageFrequency(const int page) const
 
 size_t Host::getUniquePageCount() const
 {
-    return pageFrequencies.size();
+    return uniquePageCount;
 }
 
 size_t Host::countPagesWithGuest(const Guest &guest) const
@@ -84,7 +133,7 @@ size_t Host::getGuestCount() const
 
 bool Host::isOverfull() const
 {
-    return pageFrequencies.size() > capacity;
+    return uniquePageCount > capacity;
 }
 
 bool Host::hasGuest(const std::shared_ptr<const Guest> &guest) const
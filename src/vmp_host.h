@@ -5,14 +5,34 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <vmp_guest.h>
+#include <vmp_pagesketch.h>
 
 namespace vmp
 {
 
+/**
+ * What screening guests for a host by the sketches of their pages finds.
+ * - `SCREENING_FITS` if they fit for certain, as their page counts and the host's sum to at most
+ *   its capacity.
+ * - `SCREENING_OVERFULL` if the estimated union of their pages with the host's is over its
+ *   capacity by more than `Host::SCREENING_MARGIN` relative standard errors. The guests are then
+ *   all but certain not to fit, though a wild estimate may reject guests that would have.
+ * - `SCREENING_UNCERTAIN` otherwise, when only counting the union exactly can tell.
+ */
+enum PageScreening
+{
+    SCREENING_FITS = 0,
+    SCREENING_OVERFULL,
+    SCREENING_UNCERTAIN
+};
+
 class Host
 {
   public:
+    static constexpr double SCREENING_MARGIN = 4;
+
     explicit Host(size_t capacity);
 
     /**
@@ -38,6 +58,54 @@ class Host
         return countPagesWithGuests(guestsBegin, guestsEnd) <= capacity;
     }
 
+    /**
+     * Screens a guest for the host by the sketch of its pages, without counting them. Unlike
+     * `accommodatesGuest`, this may reject a guest that fits, so it suits only heuristics that
+     * would rather skip an unlikely fit than count it.
+     *
+     * The host's sketch is only kept once the host is first screened. It is merged anew from its
+     * guests on that screening and on the first after a guest is removed, and the guests added
+     * since are merged on the next, so screening a host is not safe concurrently with anything
+     * else on it.
+     *
+     * @param guest the guest
+     * @return what the screening finds
+     */
+    [[nodiscard]] PageScreening screenGuest(const Guest &guest) const;
+
+    /**
+     * Screens a set of guests for the host by merging the sketches of their pages, without
+     * counting them, as `screenGuest`
+     *
+     * @tparam GuestIt any iterator type over `std::shared_ptr<const Guest>`
+     * @param guestsBegin the start of the guest range
+     * @param guestsEnd the end of the guest range
+     * @return what the screening finds
+     */
+    template <SharedPtrIterator<const Guest> GuestIt>
+    [[nodiscard]] PageScreening screenGuests(GuestIt guestsBegin, GuestIt guestsEnd) const
+    {
+        PageSketch guestsSketch;
+        size_t guestsPageCount = 0;
+        for (; guestsBegin != guestsEnd; ++guestsBegin) {
+            guestsSketch.merge((*guestsBegin)->getSketch());
+            guestsPageCount += (*guestsBegin)->getUniquePageCount();
+        }
+        return screenSketch(guestsSketch, guestsPageCount);
+    }
+
+    /**
+     * Screens a set of guests for the host by a sketch of their pages, as `screenGuest`, e.g. one
+     * merged once for a set of guests to be screened for many hosts
+     *
+     * @param guestsSketch the sketch of the guests' pages
+     * @param guestsPageCount the sum of the guests' unique page counts, or any other upper bound
+     *        on the number of their unique pages
+     * @return what the screening finds
+     */
+    [[nodiscard]] PageScreening screenSketch(const PageSketch &guestsSketch,
+                                             size_t guestsPageCount) const;
+
     /**
      * Count the number of *unique* pages on this host but not the guest
      *
@@ -67,14 +135,15 @@ class Host
     [[nodiscard]] size_t countPagesWithGuests(GuestIt guestsBegin, GuestIt guestsEnd) const
     {
         std::unordered_set<int> newPages;
+        size_t newPageCount = 0;
         for (; guestsBegin != guestsEnd; ++guestsBegin) {
             for (const int page : (*guestsBegin)->pages) {
-                if (!pageFrequencies.contains(page)) {
-                    newPages.insert(page);
+                if (!pageFrequencies.contains(page) && newPages.insert(page).second) {
+                    newPageCount += (*guestsBegin)->getPageWeight(page);
                 }
             }
         }
-        return newPages.size() + pageFrequencies.size();
+        return newPageCount + uniquePageCount;
     }
 
     /**
@@ -93,7 +162,7 @@ class Host
     [[nodiscard]] const std::unordered_map<int, int> &getPageFrequencies() const;
 
     /**
-     * The number of *unique* pages on this host
+     * The number of *unique* pages on this host, each counted by its weight on its guests
      *
      * @return the number of *unique* pages on this host
      */
@@ -123,6 +192,14 @@ class Host
     // Store page frequencies as the number of guests that have a page is
     // useful some Grange heuristics
     std::unordered_map<int, int> pageFrequencies;
+    size_t uniquePageCount;  // The total weight of the pages in `pageFrequencies`
+
+    // The merged sketches of the guests, which is merged anew when next screened once stale, and
+    // is stale until the host is first screened. Guests added to a fresh sketch wait to be merged
+    // until the next screening, so that hosts never screened do not pay for it.
+    mutable PageSketch sketch;
+    mutable std::vector<const Guest *> unsketchedGuests;
+    mutable bool sketchIsStale;
 
     const size_t capacity;
     std::unordered_set<std::shared_ptr<const Guest>> guests;
@@ -0,0 +1,78 @@
+#include <vmp_hostlsh.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace vmp
+{
+
+HostLshIndex::HostLshIndex(const size_t bandCount, const size_t rowsPerBand, const uint64_t seed)
+    : hasher(bandCount * rowsPerBand, seed), bandCount(bandCount), rowsPerBand(rowsPerBand),
+      buckets(bandCount)
+{
+}
+
+std::vector<uint64_t> HostLshIndex::signGuest(const Guest &guest) const
+{
+    return hasher.sign(guest.pages);
+}
+
+uint64_t HostLshIndex::hashBand(const std::span<const uint64_t> signature, const size_t band) const
+{
+    // As in boost::hash_combine, over the hashes of the band
+    uint64_t hash = band;
+    for (const uint64_t row : signature.subspan(band * rowsPerBand, rowsPerBand)) {
+        hash ^= row + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+std::vector<size_t> HostLshIndex::findCandidates(const std::span<const uint64_t> signature) const
+{
+    std::unordered_set<size_t> candidates;
+    for (size_t band = 0; band < bandCount; ++band) {
+        const auto it = buckets[band].find(hashBand(signature, band));
+        if (it != buckets[band].end()) {
+            candidates.insert(it->second.begin(), it->second.end());
+        }
+    }
+
+    std::vector<size_t> result(candidates.begin(), candidates.end());
+    std::ranges::sort(result);
+    return result;
+}
+
+void HostLshIndex::addToHost(const size_t host, const std::span<const uint64_t> signature)
+{
+    const size_t hashCount = hasher.getHashCount();
+    if (host >= hostsAreIndexed.size()) {
+        hostSignatures.resize((host + 1) * hashCount, std::numeric_limits<uint64_t>::max());
+        hostsAreIndexed.resize(host + 1);
+    }
+
+    const std::span<uint64_t> hostSignature(hostSignatures.data() + host * hashCount, hashCount);
+    std::vector<uint64_t> oldBandHashes(bandCount);
+    for (size_t band = 0; band < bandCount; ++band) {
+        oldBandHashes[band] = hashBand(hostSignature, band);
+    }
+
+    MinHasher::mergeInto(hostSignature, signature);
+
+    for (size_t band = 0; band < bandCount; ++band) {
+        const uint64_t bandHash = hashBand(hostSignature, band);
+        if (hostsAreIndexed[host] && bandHash == oldBandHashes[band]) {
+            continue;
+        }
+        if (hostsAreIndexed[host]) {
+            const auto it = buckets[band].find(oldBandHashes[band]);
+            it->second.erase(host);
+            if (it->second.empty()) {
+                buckets[band].erase(it);
+            }
+        }
+        buckets[band][bandHash].insert(host);
+    }
+    hostsAreIndexed[host] = true;
+}
+
+}  // namespace vmp
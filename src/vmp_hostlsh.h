@@ -0,0 +1,74 @@
+#ifndef VMP_HOSTLSH_H
+#define VMP_HOSTLSH_H
+
+#include <vmp_guest.h>
+#include <vmp_minhash.h>
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * A locality-sensitive hashing index of hosts by the MinHash signatures of their page sets, with
+ * which to find the hosts likely to share many pages with a guest without scanning every host.
+ *
+ * Each signature is cut into `bandCount` bands of `rowsPerBand` hashes, and a host is a candidate
+ * for a guest if their signatures agree on all of a band. A host whose page set has Jaccard
+ * similarity s with the guest's is thus a candidate with probability 1 - (1 - s^rows)^bands: more
+ * bands raise recall, and more rows per band make the candidates fewer and more similar.
+ *
+ * A host's signature is the elementwise minimum of its guests', so it is kept up to date as guests
+ * are added, moving the host only between the buckets of the bands that changed.
+ */
+class HostLshIndex
+{
+  public:
+    /**
+     * @param bandCount the number of bands
+     * @param rowsPerBand the number of hashes in each band
+     * @param seed the seed of the hash functions. Defaults to 0.
+     */
+    HostLshIndex(size_t bandCount, size_t rowsPerBand, uint64_t seed = 0);
+
+    /**
+     * @return the signature of a guest's pages, for `findCandidates` and `addToHost`
+     */
+    [[nodiscard]] std::vector<uint64_t> signGuest(const Guest &guest) const;
+
+    /**
+     * @param signature the signature of a guest
+     * @return the indices of the hosts agreeing with it on at least one band, in ascending order
+     */
+    [[nodiscard]] std::vector<size_t> findCandidates(std::span<const uint64_t> signature) const;
+
+    /**
+     * Records that a guest was added to a host
+     *
+     * @param host the index of the host, which may be one not seen before
+     * @param signature the signature of the guest
+     */
+    void addToHost(size_t host, std::span<const uint64_t> signature);
+
+  private:
+    [[nodiscard]] uint64_t hashBand(std::span<const uint64_t> signature, size_t band) const;
+
+    MinHasher hasher;
+    const size_t bandCount;
+    const size_t rowsPerBand;
+
+    // The signatures of the hosts, one after another, and whether each host is in the buckets yet
+    std::vector<uint64_t> hostSignatures;
+    std::vector<bool> hostsAreIndexed;
+
+    // The hosts by the hash of each of their bands
+    std::vector<std::unordered_map<uint64_t, std::unordered_set<size_t>>> buckets;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_HOSTLSH_H
@@ -0,0 +1,138 @@
+#include <vmp_kernelisation.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace vmp
+{
+
+/* Finds the kernel guest that absorbs each guest, as indices into `guests`, or none for kernel
+ * guests themselves*/
+static std::vector<std::optional<size_t>>
+findAbsorbers(const std::vector<std::shared_ptr<const Guest>> &guests)
+{
+    // A guest can only be absorbed by one with at least as many pages, so the larger are settled
+    // first, and the first of identical guests before the rest
+    std::vector<size_t> order(guests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::greater{},
+                             [&](const size_t guest) { return guests[guest]->pages.size(); });
+
+    std::vector<std::optional<size_t>> absorbers(guests.size());
+    std::unordered_map<int, std::vector<size_t>> kernelGuestsOfPages;
+    std::optional<size_t> anyKernelGuest;
+
+    for (const size_t guest : order) {
+        const auto &pages = guests[guest]->pages;
+
+        // Any absorber holds every page, so only the kernel guests holding the rarest need trying
+        const std::vector<size_t> *candidates = nullptr;
+        bool absorbable = true;
+        for (const int page : pages) {
+            const auto it = kernelGuestsOfPages.find(page);
+            if (it == kernelGuestsOfPages.end()) {
+                absorbable = false;
+                break;
+            }
+            if (candidates == nullptr || it->second.size() < candidates->size()) {
+                candidates = &it->second;
+            }
+        }
+
+        if (absorbable && candidates == nullptr) {
+            // A guest without pages fits with any guest
+            absorbers[guest] = anyKernelGuest;
+        }
+        else if (absorbable) {
+            const auto it = std::ranges::find_if(*candidates, [&](const size_t candidate) {
+                const auto &candidatePages = guests[candidate]->pages;
+                return std::ranges::all_of(
+                    pages, [&](const int page) { return candidatePages.contains(page); });
+            });
+            if (it != candidates->end()) {
+                absorbers[guest] = *it;
+            }
+        }
+
+        if (!absorbers[guest].has_value()) {
+            for (const int page : pages) {
+                kernelGuestsOfPages[page].push_back(guest);
+            }
+            anyKernelGuest = anyKernelGuest.value_or(guest);
+        }
+    }
+
+    return absorbers;
+}
+
+/* The guests of the kernel, in the order given*/
+static std::vector<std::shared_ptr<const Guest>>
+selectKernelGuests(const std::vector<std::shared_ptr<const Guest>> &guests,
+                   const std::vector<std::optional<size_t>> &absorbers)
+{
+    std::vector<std::shared_ptr<const Guest>> kernelGuests;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        if (!absorbers[guest].has_value()) {
+            kernelGuests.push_back(guests[guest]);
+        }
+    }
+    return kernelGuests;
+}
+
+KernelisedInstance::KernelisedInstance(const GeneralInstance &instance)
+    : KernelisedInstance(instance, findAbsorbers(instance.getGuests()))
+{
+}
+
+KernelisedInstance::KernelisedInstance(const GeneralInstance &instance,
+                                       const std::vector<std::optional<size_t>> &absorbers)
+    : kernel(instance.getCapacity(), selectKernelGuests(instance.getGuests(), absorbers))
+{
+    const auto &guests = instance.getGuests();
+    for (const auto &guest : kernel.getGuests()) {
+        weights[guest] = 1;
+    }
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        if (absorbers[guest].has_value()) {
+            const auto &absorber = guests[*absorbers[guest]];
+            absorbedGuests[absorber].push_back(guests[guest]);
+            ++weights[absorber];
+        }
+    }
+}
+
+const GeneralInstance &KernelisedInstance::getKernel() const
+{
+    return kernel;
+}
+
+const std::unordered_map<std::shared_ptr<const Guest>, int> &KernelisedInstance::getWeights() const
+{
+    return weights;
+}
+
+Packing KernelisedInstance::expandPacking(const Packing &packing) const
+{
+    std::vector<std::shared_ptr<Host>> hosts;
+    hosts.reserve(packing.getHostCount());
+    for (const auto &host : packing.getHosts()) {
+        auto &expanded = hosts.emplace_back(std::make_shared<Host>(host->getCapacity()));
+        for (const auto &guest : host->getGuests()) {
+            expanded->addGuest(guest);
+            const auto it = absorbedGuests.find(guest);
+            if (it != absorbedGuests.end()) {
+                expanded->addGuests(it->second.begin(), it->second.end());
+            }
+        }
+    }
+    return Packing(hosts);
+}
+
+Packing solveByKernel(const GeneralInstance &instance,
+                      const std::function<Packing(const GeneralInstance &)> &solver)
+{
+    const KernelisedInstance kernelised(instance);
+    return kernelised.expandPacking(solver(kernelised.getKernel()));
+}
+
+}  // namespace vmp
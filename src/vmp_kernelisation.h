@@ -0,0 +1,72 @@
+#ifndef VMP_KERNELISATION_H
+#define VMP_KERNELISATION_H
+
+#include <vmp_generalinstance.h>
+#include <vmp_packing.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * An instance reduced to its kernel: the guests whose pages no other guest's pages contain. Each
+ * other guest, be it a clone of a kernel guest or one whose pages are a strict subset of a kernel
+ * guest's, is absorbed by such a kernel guest, as it adds no pages to the host of that guest and so
+ * always fits alongside it. Of identical guests, the first is kept.
+ *
+ * A packing of the kernel is expanded into a packing of the instance by placing each absorbed guest
+ * on the host of the guest that absorbed it, which uses no more hosts and no more pages on any.
+ */
+class KernelisedInstance
+{
+  public:
+    explicit KernelisedInstance(const GeneralInstance &instance);
+
+    /**
+     * @return the instance of the kernel guests, in the order given, with the same capacity
+     */
+    [[nodiscard]] const GeneralInstance &getKernel() const;
+
+    /**
+     * @return the number of guests each kernel guest stands for, itself included, e.g. as profits
+     *         for the maximisers
+     */
+    [[nodiscard]] const std::unordered_map<std::shared_ptr<const Guest>, int> &getWeights() const;
+
+    /**
+     * Places the absorbed guests on the hosts of the kernel guests that absorbed them
+     *
+     * @param packing a packing of the kernel
+     * @return a packing of the instance, with a host for each host of the packing
+     */
+    [[nodiscard]] Packing expandPacking(const Packing &packing) const;
+
+  private:
+    KernelisedInstance(const GeneralInstance &instance,
+                       const std::vector<std::optional<size_t>> &absorbers);
+
+    GeneralInstance kernel;
+    std::unordered_map<std::shared_ptr<const Guest>, int> weights;
+    std::unordered_map<std::shared_ptr<const Guest>, std::vector<std::shared_ptr<const Guest>>>
+        absorbedGuests;
+};
+
+/**
+ * Solves VM-PACK by solving the kernel of an instance, as in `KernelisedInstance`, and expanding
+ * its packing. On instances with many cloned guests, the solver sees far fewer guests.
+ *
+ * @param instance the instance to solve
+ * @param solver the solver with which to pack the kernel, e.g. `solveByFirstFit`
+ * @return a valid packing, if the solver gives valid packings
+ */
+Packing solveByKernel(const GeneralInstance &instance,
+                      const std::function<Packing(const GeneralInstance &)> &solver);
+
+}  // namespace vmp
+
+#endif  // VMP_KERNELISATION_H
@@ -1,14 +1,101 @@
 #include <vmp_maximisers.h>
 
 #include <vmp_clustertreeinstance.h>
+#include <vmp_frozenclustertreeinstance.h>
+#include <vmp_minplus.h>
+#include <vmp_threadpool.h>
 
+#include <bit>
 #include <cassert>
+#include <cmath>
+#include <optional>
 #include <queue>
-#include <unordered_set>
+#include <set>
+#include <stack>
+#include <variant>
 
 namespace vmp
 {
 
+static bool next_combination(std::vector<int> &indices, const size_t n)
+{
+    const int k = static_cast<int>(indices.size());
+    for (int i = k - 1; i >= 0; --i) {
+        if (indices[i] >= static_cast<int>(n) - k + i) {
+            continue;
+        }
+        ++indices[i];
+        for (int j = i + 1; j < k; ++j) {
+            indices[j] = indices[j - 1] + 1;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Finds the most efficient subset of guests to place on a host given a
+ * mandatory subset size, accounting for the reward and page sharing within
+ * the subset and with the host.
+ *
+ * @param unplaced the pool of guests to sample
+ * @param host the host to place the guests on
+ * @param subsetSize the number of guests to place
+ * @return the most efficient subset of guests, or `std::nullopt` if no viable subset exists
+ */
+static std::optional<std::vector<std::pair<std::shared_ptr<const Guest>, int>>>
+findMostEfficientSubset(const std::unordered_map<std::shared_ptr<const Guest>, int> &unplaced,
+                        const Host &host, int subsetSize)
+{
+    std::vector<std::pair<std::shared_ptr<const Guest>, int>> guests(unplaced.begin(),
+                                                                     unplaced.end());
+    const int guestCount = static_cast<int>(guests.size());
+    subsetSize = std::min(guestCount, subsetSize);
+
+    std::optional<std::vector<std::pair<std::shared_ptr<const Guest>, int>>> bestSubset;
+    double bestSubsetValue = 0.0;
+
+    std::vector<int> indices(subsetSize);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    do {
+        std::vector<std::pair<std::shared_ptr<const Guest>, int>> subset;
+        subset.reserve(subsetSize);
+        for (const int index : indices) {
+            subset.emplace_back(guests[index]);
+        }
+
+        std::vector<std::shared_ptr<const Guest>> candidateView;
+        candidateView.reserve(subsetSize);
+        for (const auto &guest : subset | std::views::keys) {
+            candidateView.push_back(guest);
+        }
+
+        // Subsets clearly too large for the host are skipped without counting their pages
+        if (host.screenGuests(candidateView.begin(), candidateView.end()) == SCREENING_OVERFULL) {
+            continue;
+        }
+
+        const size_t pageCount =
+            host.countPagesWithGuests(candidateView.begin(), candidateView.end());
+        if (pageCount > host.getCapacity()) {
+            continue;
+        }
+
+        const double rewardSum =
+            std::accumulate(subset.begin(), subset.end(), 0.0,
+                            [](double acc, const auto &guest) { return acc + guest.second; });
+        const double subsetValue = rewardSum / static_cast<double>(1 + pageCount);
+
+        if (subsetValue > bestSubsetValue) {
+            bestSubset = std::move(subset);
+            bestSubsetValue = subsetValue;
+        }
+    } while (next_combination(indices, guestCount));
+
+    return bestSubset;
+}
+
 Host maximiseOneHostBySubsetEfficiency(
     const GeneralInstance &instance,
     const std::unordered_map<std::shared_ptr<const Guest>, int> &profits, int initialSubsetSize)
@@ -36,183 +123,1159 @@ Host maximiseOneHostBySubsetEfficiency(
     return host;
 }
 
-/* Suppose s is a subset of the nodes of a cluster n, and p is a profit
- * target. cost[n, s, j, p] is the least page count by which we can achieve
- * >= p by packing s on the server and optionally using nodes from the
- * first j children clusters of n.*/
-struct ProfitOption
+/* A cluster of up to the exhaustive width considers every one of the 2^n selections of its nodes.
+ * A wider cluster considers only a bounded beam of candidate selections, which it grows one node at
+ * a time from the empty selection, keeping the most promising ones at each step.*/
+static constexpr size_t WIDE_CLUSTER_BEAM_WIDTH = 32;
+static constexpr size_t WIDE_CLUSTER_MAX_SELECTIONS = 512;
+
+static size_t countWords(const size_t bitCount)
 {
-    size_t cluster;        // scenario considers the subtree rooted here
-    size_t selectionMask;  // the nodes selected from this cluster
-    size_t childCount;  // the subtrees rooted at children [0...childCount-1] of this cluster can be
-                        // used
-    size_t profitTarget;
+    return std::max<size_t>(1, (bitCount + 63) / 64);
+}
+
+static bool testBit(const uint64_t *bits, const size_t i)
+{
+    return bits[i / 64] & 1ULL << i % 64;
+}
+
+/* The selections of nodes the DP considers for a cluster n, each known by an index:
+ * - if n is exhaustive, every selection, where the index of a selection is its mask; and
+ * - otherwise, the candidates chosen for it, each stored as a bitset of wordCount words.
+ * pageCounts[s] is |union pages in s| for each selection s. For the i-th node of n, the bitset of
+ * parentWordCount words at parentBits[i * parentWordCount] has bit k set if the k-th node of the
+ * parent of n is a parent of that node.*/
+struct ClusterSelections
+{
+    size_t nodeCount;
+    size_t wordCount;
+    size_t parentWordCount;
+    bool exhaustive;
+
+    std::vector<uint64_t> parentBits;
+    std::vector<uint64_t> candidateBits;
+    std::vector<size_t> pageCounts;
 
-    bool operator==(const ProfitOption &) const = default;
+    // The pages of each node as a bitset over the pages of the cluster, indexed densely
+    size_t pageWordCount;
+    std::vector<uint64_t> nodePageBits;
 
-    [[nodiscard]] size_t hash() const
+    [[nodiscard]] size_t count() const { return pageCounts.size(); }
+
+    /* The bitset of a selection, where `maskWord` backs that of an exhaustive cluster's selection*/
+    [[nodiscard]] const uint64_t *bitsOf(const size_t selection, uint64_t &maskWord) const
     {
-        size_t h = std::hash<size_t>{}(cluster);
-        h ^= std::hash<size_t>{}(selectionMask);
-        h ^= std::hash<size_t>{}(childCount);
-        h ^= std::hash<size_t>{}(profitTarget);
-        return h;
+        if (exhaustive) {
+            maskWord = selection;
+            return &maskWord;
+        }
+        return candidateBits.data() + selection * wordCount;
+    }
+
+    [[nodiscard]] bool isSubsetOf(const size_t selection, const std::vector<uint64_t> &bits) const
+    {
+        uint64_t maskWord;
+        const uint64_t *selectionBits = bitsOf(selection, maskWord);
+        for (size_t word = 0; word < wordCount; ++word) {
+            if (selectionBits[word] & ~bits[word]) {
+                return false;
+            }
+        }
+        return true;
     }
 };
 
-struct GuestSelection
+static std::vector<uint64_t> makeParentBits(const FrozenClusterTreeInstance &instance,
+                                            const size_t cluster, const size_t parentWordCount)
 {
-    size_t pageCount;
+    const auto nodes = instance.getClusterNodes(cluster);
+    const auto parentPool =
+        instance.getClusterNodes(instance.getClusterParent(cluster));
 
-    // TODO avoid copying guests, instead reference other entries in the cost table and backtrack
-    std::vector<std::shared_ptr<const Guest>> guests;
+    std::unordered_map<size_t, size_t> parentPositions;
+    for (size_t k = 0; k < parentPool.size(); ++k) {
+        parentPositions.try_emplace(parentPool[k], k);
+    }
 
-    GuestSelection() : pageCount(std::numeric_limits<int>::max()) {}
-    GuestSelection(const size_t pageCount, const std::vector<std::shared_ptr<const Guest>> &guests)
-        : pageCount(pageCount), guests(guests)
-    {
+    std::vector<uint64_t> parentBits(nodes.size() * parentWordCount);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const size_t parent : instance.getNodeParents(nodes[i])) {
+            const auto it = parentPositions.find(parent);
+            if (it != parentPositions.end()) {
+                parentBits[i * parentWordCount + it->second / 64] |= 1ULL << it->second % 64;
+            }
+        }
+    }
+    return parentBits;
+}
+
+static std::vector<uint64_t> makeNodePageBits(const FrozenClusterTreeInstance &instance,
+                                              const std::span<const uint32_t> pool,
+                                              size_t &pageWordCount)
+{
+    // Index the pages of the cluster densely, so that each node's pages are a bitset
+    std::unordered_map<int, size_t> densePages;
+    for (const size_t node : pool) {
+        for (const int page : instance.getNodePages(node)) {
+            densePages.try_emplace(page, densePages.size());
+        }
+    }
+
+    pageWordCount = countWords(densePages.size());
+    std::vector<uint64_t> nodePageBits(pool.size() * pageWordCount);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        for (const int page : instance.getNodePages(pool[i])) {
+            const size_t densePage = densePages.at(page);
+            nodePageBits[i * pageWordCount + densePage / 64] |= 1ULL << densePage % 64;
+        }
+    }
+    return nodePageBits;
+}
+
+static std::vector<size_t> countPagesBySelection(const std::vector<uint64_t> &nodePageBits,
+                                                 const size_t pageWordCount,
+                                                 const size_t nodeCount)
+{
+    assert(nodeCount < 64);
+
+    // Visit the masks in Gray code order, so that each differs from the last by a single node, and
+    // keep the union size up to date by counting how many selected nodes hold each page
+    std::vector<size_t> pageCounts(1ULL << nodeCount);
+    std::vector<size_t> pageMultiplicities(pageWordCount * 64);
+    size_t unionSize = 0;
+    uint64_t mask = 0;
+
+    for (uint64_t step = 1; step < 1ULL << nodeCount; ++step) {
+        const size_t toggled = std::countr_zero(step);
+        mask ^= 1ULL << toggled;
+        const bool adding = mask & 1ULL << toggled;
+
+        for (size_t word = 0; word < pageWordCount; ++word) {
+            for (uint64_t bits = nodePageBits[toggled * pageWordCount + word]; bits != 0;
+                 bits &= bits - 1) {
+                size_t &multiplicity = pageMultiplicities[word * 64 + std::countr_zero(bits)];
+                if (adding && multiplicity++ == 0) {
+                    ++unionSize;
+                }
+                else if (!adding && --multiplicity == 0) {
+                    --unionSize;
+                }
+            }
+        }
+        pageCounts[mask] = unionSize;
+    }
+
+    return pageCounts;
+}
+
+static ClusterSelections makeClusterSelections(const FrozenClusterTreeInstance &instance,
+                                               const size_t cluster, const size_t exhaustiveWidth)
+{
+    const auto nodes = instance.getClusterNodes(cluster);
+    const size_t parentNodeCount =
+        instance.getClusterNodes(instance.getClusterParent(cluster)).size();
+
+    ClusterSelections selections;
+    selections.nodeCount = nodes.size();
+    selections.wordCount = countWords(nodes.size());
+    selections.parentWordCount = countWords(parentNodeCount);
+    selections.exhaustive =
+        nodes.size() <= std::min(exhaustiveWidth, MAX_EXHAUSTIVE_CLUSTER_WIDTH);
+    selections.parentBits = makeParentBits(instance, cluster, selections.parentWordCount);
+    selections.nodePageBits = makeNodePageBits(instance, nodes, selections.pageWordCount);
+
+    // The candidates of a wide cluster depend on its children, so are chosen only once it is ready
+    if (selections.exhaustive) {
+        selections.pageCounts =
+            countPagesBySelection(selections.nodePageBits, selections.pageWordCount, nodes.size());
+    }
+    return selections;
+}
+
+/* Sets `accessible` to the nodes of a child cluster with at least one parent in the selection*/
+static void makeAccessibleChildrenBits(const ClusterSelections &childSelections,
+                                       const uint64_t *selectionBits,
+                                       std::vector<uint64_t> &accessible)
+{
+    accessible.assign(childSelections.wordCount, 0);
+    for (size_t i = 0; i < childSelections.nodeCount; ++i) {
+        const uint64_t *parents =
+            childSelections.parentBits.data() + i * childSelections.parentWordCount;
+        for (size_t word = 0; word < childSelections.parentWordCount; ++word) {
+            if (parents[word] & selectionBits[word]) {
+                accessible[i / 64] |= 1ULL << i % 64;
+                break;
+            }
+        }
     }
+}
+
+static size_t
+sumProfitOfNodes(const FrozenClusterTreeInstance &instance, const std::span<const uint32_t> pool,
+                 const uint64_t *bits, const size_t wordCount,
+                 const std::unordered_map<std::shared_ptr<const Guest>, int> &profits)
+{
+    size_t profit = 0;
+    for (size_t word = 0; word < wordCount; ++word) {
+        for (uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1) {
+            const size_t node = pool[word * 64 + std::countr_zero(remaining)];
+            if (instance.nodeIsLeaf(node)) {
+                profit += profits.at(instance.getNodeGuest(node));
+            }
+        }
+    }
+    return profit;
+}
 
-    void setFromSelection(const std::vector<size_t> &selection,
-                          const std::unordered_set<int> &pages, const ClusterTreeInstance &instance)
+static std::vector<size_t>
+sumProfitsBySelection(const FrozenClusterTreeInstance &instance,
+                      const std::span<const uint32_t> pool, const ClusterSelections &selections,
+                      const std::unordered_map<std::shared_ptr<const Guest>, int> &profits)
+{
+    std::vector<size_t> profitSums(selections.count());
+
+    if (!selections.exhaustive) {
+        for (size_t selection = 0; selection < selections.count(); ++selection) {
+            uint64_t maskWord;
+            profitSums[selection] = sumProfitOfNodes(
+                instance, pool, selections.bitsOf(selection, maskWord), selections.wordCount,
+                profits);
+        }
+        return profitSums;
+    }
+
+    for (uint64_t mask = 1; mask < selections.count(); ++mask) {
+        // Extend the sum of the mask without its lowest node
+        const size_t node = pool[std::countr_zero(mask)];
+        const size_t nodeProfit =
+            instance.nodeIsLeaf(node) ? profits.at(instance.getNodeGuest(node)) : 0;
+        profitSums[mask] = profitSums[mask & (mask - 1)] + nodeProfit;
+    }
+    return profitSums;
+}
+
+/* Chooses the candidate selections of a wide cluster by a beam search. A selection is promising if
+ * it makes much profit, or gives access to much of its children's subtrees, for few pages.*/
+static void chooseCandidateSelections(
+    const FrozenClusterTreeInstance &instance, const size_t cluster,
+    std::vector<ClusterSelections> &allSelections, const std::vector<size_t> &subtreeProfits,
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits, const size_t capacity)
+{
+    ClusterSelections &selections = allSelections[cluster];
+    const auto nodes = instance.getClusterNodes(cluster);
+    const auto children = instance.getClusterChildren(cluster);
+
+    struct Candidate
     {
-        pageCount = static_cast<int>(pages.size());
-        guests.clear();
-        guests.reserve(selection.size());
+        std::vector<uint64_t> bits;
+        std::vector<uint64_t> pageBits;
+        size_t pageCount;
+        double promise;
+    };
+
+    std::vector<uint64_t> accessible;
+    auto assessPromise = [&](const Candidate &candidate) {
+        double value = static_cast<double>(sumProfitOfNodes(
+            instance, nodes, candidate.bits.data(), selections.wordCount, profits));
+
+        for (const size_t child : children) {
+            makeAccessibleChildrenBits(allSelections[child], candidate.bits.data(), accessible);
+
+            size_t accessibleCount = 0;
+            for (const uint64_t word : accessible) {
+                accessibleCount += std::popcount(word);
+            }
+            const size_t childNodeCount = std::max<size_t>(1, allSelections[child].nodeCount);
+            value += static_cast<double>(subtreeProfits[child] * accessibleCount) /
+                     static_cast<double>(childNodeCount);
+        }
+        return value / static_cast<double>(1 + candidate.pageCount);
+    };
 
-        for (const size_t selected : selection) {
+    std::vector<uint64_t> candidateBits;
+    std::vector<size_t> pageCounts;
+    auto keep = [&](const Candidate &candidate) {
+        candidateBits.insert(candidateBits.end(), candidate.bits.begin(), candidate.bits.end());
+        pageCounts.push_back(candidate.pageCount);
+    };
+
+    std::set<std::vector<uint64_t>> seen;
+    std::vector<Candidate> beam{ { std::vector<uint64_t>(selections.wordCount),
+                                   std::vector<uint64_t>(selections.pageWordCount), 0, 0.0 } };
+    seen.insert(beam.front().bits);
+    keep(beam.front());
+
+    while (!beam.empty() && pageCounts.size() < WIDE_CLUSTER_MAX_SELECTIONS) {
+        std::vector<Candidate> expansions;
+
+        for (const Candidate &candidate : beam) {
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (testBit(candidate.bits.data(), i)) {
+                    continue;
+                }
+
+                Candidate expansion = candidate;
+                expansion.bits[i / 64] |= 1ULL << i % 64;
+                expansion.pageCount = 0;
+                for (size_t word = 0; word < selections.pageWordCount; ++word) {
+                    expansion.pageBits[word] |=
+                        selections.nodePageBits[i * selections.pageWordCount + word];
+                    expansion.pageCount += std::popcount(expansion.pageBits[word]);
+                }
+
+                if (expansion.pageCount > capacity || !seen.insert(expansion.bits).second) {
+                    continue;
+                }
+                expansion.promise = assessPromise(expansion);
+                expansions.push_back(std::move(expansion));
+            }
+        }
+
+        std::ranges::stable_sort(expansions, std::ranges::greater{}, &Candidate::promise);
+        expansions.resize(std::min(
+            { expansions.size(), WIDE_CLUSTER_BEAM_WIDTH,
+              WIDE_CLUSTER_MAX_SELECTIONS - pageCounts.size() }));
+
+        for (const Candidate &expansion : expansions) {
+            keep(expansion);
+        }
+        beam = std::move(expansions);
+    }
+
+    selections.candidateBits = std::move(candidateBits);
+    selections.pageCounts = std::move(pageCounts);
+}
+
+static void collectLeafGuests(const FrozenClusterTreeInstance &instance,
+                              const std::span<const uint32_t> pool, const uint64_t *bits,
+                              const size_t wordCount,
+                              std::vector<std::shared_ptr<const Guest>> &guests)
+{
+    for (size_t word = 0; word < wordCount; ++word) {
+        for (uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1) {
+            const size_t selected = pool[word * 64 + std::countr_zero(remaining)];
             if (instance.nodeIsLeaf(selected)) {
                 guests.push_back(instance.getNodeGuest(selected));
             }
         }
     }
+}
+
+/* Sets `bits` to every node of a cluster*/
+static void makeEveryNodeBits(const ClusterSelections &clusterSelections,
+                              std::vector<uint64_t> &bits)
+{
+    bits.assign(clusterSelections.wordCount, 0);
+    for (size_t i = 0; i < clusterSelections.nodeCount; ++i) {
+        bits[i / 64] |= 1ULL << i % 64;
+    }
+}
+
+/* What both modes of the DP keep about each cluster besides their tables: its selections, the
+ * profit of each of them, and the total profit of the leaves of its subtree.
+ *
+ * Each mode keeps, per cluster, only the summary its parent looks up: the best over the selections
+ * within each accessible set of nodes. The states for the first j < deg(n) children are computed
+ * for one selection at a time and dropped, and are recomputed for the few selections that
+ * reconstruction visits. The bytes held by the tables are counted as they are allocated and
+ * freed.*/
+struct ClusterTreeDpBase
+{
+    const FrozenClusterTreeInstance &instance;
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits;
+    const uint32_t capacity;
+
+    std::vector<ClusterSelections> selections;
+    std::vector<std::vector<size_t>> selectionProfits;
+
+    // The profit upper bound at each subtree is the sum of the profits in its leaves
+    std::vector<size_t> profitUpperBounds;
+
+    std::atomic<size_t> liveTableBytes;
+    std::atomic<size_t> peakTableBytes;
+
+    ClusterTreeDpBase(const FrozenClusterTreeInstance &instance,
+                      const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
+                      const size_t exhaustiveWidth)
+        : instance(instance),
+          profits(profits),
+          capacity(static_cast<uint32_t>(instance.getCapacity())),
+          selections(instance.getClusterCount()),
+          selectionProfits(instance.getClusterCount()),
+          profitUpperBounds(instance.getClusterCount()),
+          liveTableBytes(0),
+          peakTableBytes(0)
+    {
+        for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
+            selections[cluster] = makeClusterSelections(instance, cluster, exhaustiveWidth);
+        }
+    }
 
-    void setFromCombinationOfDisjoint(const GuestSelection &a, const GuestSelection &b)
+    [[nodiscard]] size_t countSelections(const size_t cluster) const
     {
-        pageCount = a.pageCount + b.pageCount;
+        return selections[cluster].count();
+    }
 
-        guests.clear();
-        guests.reserve(a.guests.size() + b.guests.size());
-        guests.insert(guests.end(), a.guests.begin(), a.guests.end());
-        guests.insert(guests.end(), b.guests.begin(), b.guests.end());
+    /* Counts a table of `allocatedBytes` replacing one of `freedBytes`. The new table exists before
+     * the old one is freed, so both count towards the peak.*/
+    void countTableBytes(const size_t freedBytes, const size_t allocatedBytes)
+    {
+        const size_t live = liveTableBytes.fetch_add(allocatedBytes) + allocatedBytes;
+        size_t peak = peakTableBytes.load();
+        while (live > peak && !peakTableBytes.compare_exchange_weak(peak, live)) {
+        }
+        liveTableBytes.fetch_sub(freedBytes);
     }
 
-    GuestSelection(const GuestSelection &) = default;
-    GuestSelection(GuestSelection &&) noexcept = default;
-    GuestSelection &operator=(const GuestSelection &) = default;
-    GuestSelection &operator=(GuestSelection &&) noexcept = default;
-    ~GuestSelection() = default;
+    void prepareSelections(const size_t cluster)
+    {
+        const auto curNodes = instance.getClusterNodes(cluster);
+        const auto curChildren = instance.getClusterChildren(cluster);
+
+        if (instance.clusterIsLeaf(cluster)) {
+            const auto &guest = instance.getNodeGuest(curNodes.front());
+            profitUpperBounds[cluster] = profits.at(guest);
+        }
+        else {
+            profitUpperBounds[cluster] = 0;
+            for (const size_t child : curChildren) {
+                profitUpperBounds[cluster] += profitUpperBounds[child];
+            }
+        }
+
+        if (!selections[cluster].exhaustive) {
+            chooseCandidateSelections(instance, cluster, selections, profitUpperBounds, profits,
+                                      capacity);
+        }
+        selectionProfits[cluster] =
+            sumProfitsBySelection(instance, curNodes, selections[cluster], profits);
+    }
+
+    [[nodiscard]] std::vector<std::shared_ptr<const Guest>>
+    collectGuests(const std::vector<std::pair<size_t, size_t>> &chosenSelections) const
+    {
+        std::vector<std::shared_ptr<const Guest>> guests;
+        for (const auto &[cluster, selection] : chosenSelections) {
+            uint64_t maskWord;
+            collectLeafGuests(instance, instance.getClusterNodes(cluster),
+                              selections[cluster].bitsOf(selection, maskWord),
+                              selections[cluster].wordCount, guests);
+        }
+        return guests;
+    }
 };
 
-static std::pair<std::vector<size_t>, std::unordered_set<int>>
-selectNodesByMask(const ClusterTreeInstance &instance, const std::vector<size_t> &pool,
-                  const uint64_t mask)
+/* Suppose s is a subset of the nodes of a cluster n, and p is a profit
+ * target. cost[n, s, j, p] is the least page count by which we can achieve
+ * >= p by packing s on the server and optionally using nodes from the
+ * first j children clusters of n.
+ *
+ * The table of a cluster holds, for each s, a contiguous row of the costs
+ * cost[n, s, deg(n), p] over p in [0...profitUpperBound], so that whole rows can
+ * be combined at once. Only page counts are stored; the guests are recovered by
+ * backtracking.*/
+struct ClusterCostTable
 {
-    std::unordered_set<int> pages;
-    std::vector<size_t> selection;
+    size_t profitTargetCount;  // profitUpperBound + 1, the length of each row
+    std::vector<uint32_t> costs;
 
-    for (uint64_t i = 0; i < pool.size(); ++i) {
-        if (mask & 1ULL << i) {
-            const auto &nodePages = instance.getNodePages(pool[i]);
-            pages.insert(nodePages.begin(), nodePages.end());
-            selection.push_back(pool[i]);
-        }
+    ClusterCostTable() : profitTargetCount(0) {}
+    ClusterCostTable(const size_t selectionCount, const size_t profitUpperBound)
+        : profitTargetCount(profitUpperBound + 1),
+          costs(selectionCount * profitTargetCount, INFINITE_COST)
+    {
     }
 
-    return { selection, pages };
-}
+    [[nodiscard]] uint32_t *row(const size_t selection)
+    {
+        return costs.data() + selection * profitTargetCount;
+    }
+
+    [[nodiscard]] const uint32_t *row(const size_t selection) const
+    {
+        return costs.data() + selection * profitTargetCount;
+    }
+
+    [[nodiscard]] size_t countBytes() const { return costs.capacity() * sizeof(uint32_t); }
+};
 
-static size_t makeAccessibleChildrenMask(const std::vector<size_t> &children,
-                                         const std::vector<size_t> &allowedParents,
-                                         const ClusterTreeInstance &instance)
+/* For an exhaustive cluster n, an accessible mask a over the nodes of n, and a profit target p,
+ * bestMasks[a, p] is the selection s that is a submask of a with the least cost[n, s, deg(n), p],
+ * and bestCosts[a, p] is that cost. This is the lookup a parent makes for each of its selections,
+ * so we build it once per cluster by a subset-min (zeta) transform over the masks of n rather than
+ * scanning the submasks every time. For each a, the costs form a row over p. The masks are stored
+ * in the narrowest type that holds one over the nodes of n.*/
+struct AccessibleSelectionTable
 {
-    size_t accessibleChildrenMask = 0;
-    for (int i = 0; i < children.size(); ++i) {
-        const auto &trueParents = instance.getNodeParents(children[i]);
+    size_t profitTargetCount = 0;
+    std::variant<std::vector<uint8_t>, std::vector<uint16_t>, std::vector<uint32_t>,
+                 std::vector<uint64_t>>
+        bestMasks;
+    std::vector<uint32_t> bestCosts;
 
-        for (const size_t parentCandidate : allowedParents) {
-            if (std::ranges::find(trueParents, parentCandidate) != trueParents.end()) {
-                accessibleChildrenMask |= 1ULL << i;
-                break;
+    [[nodiscard]] size_t index(const uint64_t accessibleMask, const size_t profitTarget) const
+    {
+        return accessibleMask * profitTargetCount + profitTarget;
+    }
+
+    [[nodiscard]] const uint32_t *costRow(const uint64_t accessibleMask) const
+    {
+        return bestCosts.data() + index(accessibleMask, 0);
+    }
+
+    [[nodiscard]] uint64_t bestMask(const uint64_t accessibleMask, const size_t profitTarget) const
+    {
+        const size_t i = index(accessibleMask, profitTarget);
+        return std::visit([&](const auto &masks) -> uint64_t { return masks[i]; }, bestMasks);
+    }
+
+    [[nodiscard]] size_t countBytes() const
+    {
+        const size_t maskBytes = std::visit(
+            [](const auto &masks) { return masks.capacity() * sizeof(masks.front()); }, bestMasks);
+        return maskBytes + bestCosts.capacity() * sizeof(uint32_t);
+    }
+};
+
+template <typename Mask>
+static void foldAccessibleSelections(AccessibleSelectionTable &table, const ClusterCostTable &costs,
+                                     const size_t nodeCount)
+{
+    const uint64_t maskCount = 1ULL << nodeCount;
+
+    std::vector<Mask> bestMasks(maskCount * table.profitTargetCount);
+    table.bestCosts.resize(maskCount * table.profitTargetCount);
+
+    // Every mask is trivially the best of its own singleton family of submasks
+    for (uint64_t mask = 0; mask < maskCount; ++mask) {
+        const uint32_t *finalRow = costs.row(mask);
+        for (size_t profitTarget = 0; profitTarget < table.profitTargetCount; ++profitTarget) {
+            const size_t i = table.index(mask, profitTarget);
+            bestMasks[i] = static_cast<Mask>(mask);
+            table.bestCosts[i] = finalRow[profitTarget];
+        }
+    }
+
+    // Then fold in the submasks missing one node at a time; after the pass over node `bit`, each
+    // entry is the best over the submasks that differ from it at most in nodes [0...bit]
+    for (size_t bit = 0; bit < nodeCount; ++bit) {
+        for (uint64_t mask = 0; mask < maskCount; ++mask) {
+            if (!(mask & 1ULL << bit)) {
+                continue;
+            }
+            for (size_t profitTarget = 0; profitTarget < table.profitTargetCount; ++profitTarget) {
+                const size_t to = table.index(mask, profitTarget);
+                const size_t from = table.index(mask ^ 1ULL << bit, profitTarget);
+
+                // Break ties towards the lower mask, as a scan in increasing mask order would
+                if (table.bestCosts[from] < table.bestCosts[to] ||
+                    (table.bestCosts[from] == table.bestCosts[to] &&
+                     bestMasks[from] < bestMasks[to])) {
+                    bestMasks[to] = bestMasks[from];
+                    table.bestCosts[to] = table.bestCosts[from];
+                }
             }
         }
     }
-    return accessibleChildrenMask;
+
+    table.bestMasks = std::move(bestMasks);
 }
 
-static bool checkAllAccessible(const size_t childrenMask, const size_t accessibleMask)
+static AccessibleSelectionTable buildAccessibleSelectionTable(const ClusterCostTable &costs,
+                                                              const size_t nodeCount)
 {
-    return (childrenMask & ~accessibleMask) == 0;
+    assert(nodeCount <= MAX_EXHAUSTIVE_CLUSTER_WIDTH);
+
+    AccessibleSelectionTable table;
+    table.profitTargetCount = costs.profitTargetCount;
+    if (nodeCount <= 8) {
+        foldAccessibleSelections<uint8_t>(table, costs, nodeCount);
+    }
+    else if (nodeCount <= 16) {
+        foldAccessibleSelections<uint16_t>(table, costs, nodeCount);
+    }
+    else if (nodeCount <= 32) {
+        foldAccessibleSelections<uint32_t>(table, costs, nodeCount);
+    }
+    else {
+        foldAccessibleSelections<uint64_t>(table, costs, nodeCount);
+    }
+    return table;
 }
 
-static std::optional<GuestSelection>
-findLowestCostAccessibleSelection(const auto &costs, const size_t cluster,
-                                  const size_t accessibleMask, const size_t profitTarget,
-                                  const ClusterTreeInstance &instance)
+struct ProfitScenario
 {
-    const std::vector<size_t> &nodes = instance.getClusterNodes(cluster);
-    assert(nodes.size() < 64);
+    size_t selection;
+    size_t profitTarget;
+};
 
-    std::optional<GuestSelection> lowestCost;
+/* The state of one run of the cluster-tree DP. Once all the children of a cluster are complete,
+ * the cluster is prepared (its profit bound found, its selections chosen and its table allocated),
+ * then the rows of its selections are filled, in any order and independently of each other, then
+ * it is finished (the table its parent looks up is built).*/
+struct ClusterTreeDp : ClusterTreeDpBase
+{
+    // The final rows of each cluster. An exhaustive cluster frees them once it has built its
+    // accessible selection table, while a wide cluster keeps them for its parent to scan.
+    std::vector<ClusterCostTable> costTables;
+    std::vector<AccessibleSelectionTable> accessibleSelections;
 
-    for (uint64_t selectionMask = 0; selectionMask < 1ULL << nodes.size(); ++selectionMask) {
-        if (!checkAllAccessible(selectionMask, accessibleMask)) {
-            continue;
+    ClusterTreeDp(const FrozenClusterTreeInstance &instance,
+                  const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
+                  const size_t exhaustiveWidth)
+        : ClusterTreeDpBase(instance, profits, exhaustiveWidth),
+          costTables(instance.getClusterCount()),
+          accessibleSelections(instance.getClusterCount())
+    {
+    }
+
+    void prepareCluster(const size_t cluster)
+    {
+        prepareSelections(cluster);
+
+        ClusterCostTable costs(countSelections(cluster), profitUpperBounds[cluster]);
+        countTableBytes(costTables[cluster].countBytes(), costs.countBytes());
+        costTables[cluster] = std::move(costs);
+    }
+
+    [[nodiscard]] size_t countProfitTargets(const size_t cluster) const
+    {
+        return profitUpperBounds[cluster] + 1;
+    }
+
+    /* The row of least costs over the child's selections within the accessible nodes. A wide child
+     * has no table for this, so its candidates are scanned into `scratch`.*/
+    const uint32_t *findBestAccessibleRow(const size_t child,
+                                          const std::vector<uint64_t> &accessible,
+                                          std::vector<uint32_t> &scratch) const
+    {
+        const ClusterSelections &childSelections = selections[child];
+        if (childSelections.exhaustive) {
+            return accessibleSelections[child].costRow(accessible.front());
+        }
+
+        const ClusterCostTable &childCosts = costTables[child];
+        scratch.assign(childCosts.profitTargetCount, INFINITE_COST);
+        for (size_t selection = 0; selection < childSelections.count(); ++selection) {
+            if (!childSelections.isSubsetOf(selection, accessible)) {
+                continue;
+            }
+            const uint32_t *finalRow = childCosts.row(selection);
+            for (size_t profitTarget = 0; profitTarget < scratch.size(); ++profitTarget) {
+                scratch[profitTarget] = std::min(scratch[profitTarget], finalRow[profitTarget]);
+            }
+        }
+        return scratch.data();
+    }
+
+    [[nodiscard]] size_t findBestAccessibleSelection(const size_t child,
+                                                     const std::vector<uint64_t> &accessible,
+                                                     const size_t profitTarget) const
+    {
+        const ClusterSelections &childSelections = selections[child];
+        if (childSelections.exhaustive) {
+            const AccessibleSelectionTable &table = accessibleSelections[child];
+            return table.bestMask(accessible.front(), profitTarget);
+        }
+
+        const ClusterCostTable &childCosts = costTables[child];
+        size_t best = 0;
+        for (size_t selection = 0; selection < childSelections.count(); ++selection) {
+            if (childSelections.isSubsetOf(selection, accessible) &&
+                childCosts.row(selection)[profitTarget] < childCosts.row(best)[profitTarget]) {
+                best = selection;
+            }
+        }
+        return best;
+    }
+
+    /* Computes cost[n, s, j, p] for every j and p of one selection s into `rows`, in order of j*/
+    void computeSelectionRows(const size_t cluster, const size_t selection,
+                              std::vector<uint32_t> &rows, std::vector<uint64_t> &accessible,
+                              std::vector<uint32_t> &scratch) const
+    {
+        const auto curChildren = instance.getClusterChildren(cluster);
+        const ClusterSelections &curSelections = selections[cluster];
+        const size_t rowLength = countProfitTargets(cluster);
+
+        uint64_t maskWord;
+        const uint64_t *curBits = curSelections.bitsOf(selection, maskWord);
+        const size_t curPageCount = curSelections.pageCounts[selection];
+
+        rows.assign((curChildren.size() + 1) * rowLength, INFINITE_COST);
+
+        // Initialise:
+        // cost[n,s,0,p] = if (sum profit in s) >= p then |union pages in s| else +inf
+        if (curPageCount <= capacity) {
+            std::fill_n(rows.begin(),
+                        std::min(selectionProfits[cluster][selection] + 1, rowLength),
+                        static_cast<uint32_t>(curPageCount));
+        }
+
+        // Allow taking from the first j children at a time
+        for (size_t j = 1; j <= curChildren.size(); ++j) {
+            // We will compute cost[n, s, j, p] for every p at once
+            const uint32_t *prevRow = rows.data() + (j - 1) * rowLength;
+            uint32_t *curRow = rows.data() + j * rowLength;
+
+            // Try to do better than with j - 1 children
+            std::copy_n(prevRow, rowLength, curRow);
+
+            // Only those nodes in the child cluster that have at least one parent in
+            // the current selection are accessible, as the mask must be over all the
+            // cluster's nodes. The best among the subsets of the accessible nodes is looked
+            // up from the child's table rather than searched for.
+            const size_t newChild = curChildren[j - 1];
+            makeAccessibleChildrenBits(selections[newChild], curBits, accessible);
+
+            // Try to make each `profitComplement` profit from the newly considered child
+            // cluster: cost[n, s, j, p] = min_c cost[n, s, j - 1, p - c] + bestChild[c]
+            minPlusConvolve(prevRow, rowLength,
+                            findBestAccessibleRow(newChild, accessible, scratch),
+                            countProfitTargets(newChild), curRow, rowLength);
+
+            std::replace_if(
+                curRow, curRow + rowLength,
+                [&](const uint32_t pageCount) { return pageCount > capacity; }, INFINITE_COST);
         }
+    }
 
+    void fillCostRows(const size_t cluster, const size_t selectionsBegin,
+                      const size_t selectionsEnd)
+    {
         const size_t degree = instance.getClusterChildren(cluster).size();
-        // Assume we have already processed the child nodes by topological sort
-        const auto &cost = costs.at({ cluster, selectionMask, degree, profitTarget });
+        ClusterCostTable &curCosts = costTables[cluster];
+
+        std::vector<uint32_t> rows;
+        std::vector<uint64_t> accessible;
+        std::vector<uint32_t> scratch;
 
-        if (!lowestCost.has_value() || cost.pageCount < lowestCost->pageCount) {
-            lowestCost = std::move(cost);
+        for (size_t curSelection = selectionsBegin; curSelection < selectionsEnd; ++curSelection) {
+            computeSelectionRows(cluster, curSelection, rows, accessible, scratch);
+            std::copy_n(rows.begin() + degree * curCosts.profitTargetCount,
+                        curCosts.profitTargetCount, curCosts.row(curSelection));
         }
     }
-    return lowestCost;
-}
 
-static std::optional<GuestSelection>
-findMostProfitableScenarioAtRoot(const auto &costs, const ClusterTreeInstance &instance)
+    void finishCluster(const size_t cluster)
+    {
+        if (!selections[cluster].exhaustive) {
+            return;
+        }
+
+        AccessibleSelectionTable table = buildAccessibleSelectionTable(
+            costTables[cluster], instance.getClusterNodes(cluster).size());
+        countTableBytes(accessibleSelections[cluster].countBytes(), table.countBytes());
+        accessibleSelections[cluster] = std::move(table);
+
+        // The parent, and reconstruction, only look up the accessible selection table
+        countTableBytes(costTables[cluster].countBytes(), 0);
+        costTables[cluster] = ClusterCostTable();
+    }
+
+    /* Recovers the selections of a scenario by walking back down the clusters: cost[n, s, j, p]
+     * either equals cost[n, s, j - 1, p], or it was made from cost[n, s, j - 1, p - c] and the best
+     * accessible selection of child j at profit c, for some c. The rows of each selection visited
+     * are recomputed from the tables of its children.*/
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>>
+    backtrackSelections(const ProfitScenario &rootScenario) const
+    {
+        std::vector<std::pair<size_t, size_t>> chosen;
+        std::stack<std::pair<size_t, ProfitScenario>> steps;
+        steps.emplace(ClusterTreeInstance::getRootCluster(), rootScenario);
+
+        std::vector<uint32_t> rows;
+        std::vector<uint64_t> accessible;
+        std::vector<uint32_t> scratch;
+
+        while (!steps.empty()) {
+            const auto [cluster, scenario] = steps.top();
+            steps.pop();
+
+            const auto children = instance.getClusterChildren(cluster);
+            const size_t rowLength = countProfitTargets(cluster);
+            const size_t selection = scenario.selection;
+            size_t profitTarget = scenario.profitTarget;
+
+            computeSelectionRows(cluster, selection, rows, accessible, scratch);
+
+            uint64_t maskWord;
+            const uint64_t *bits = selections[cluster].bitsOf(selection, maskWord);
+
+            for (size_t j = children.size(); j > 0; --j) {
+                const uint32_t target = rows[j * rowLength + profitTarget];
+                const uint32_t *prevRow = rows.data() + (j - 1) * rowLength;
+                if (prevRow[profitTarget] == target) {
+                    continue;
+                }
+
+                const size_t child = children[j - 1];
+                makeAccessibleChildrenBits(selections[child], bits, accessible);
+                const uint32_t *childRow = findBestAccessibleRow(child, accessible, scratch);
+
+                size_t profitComplement = 1;
+                while (profitComplement <=
+                           std::min(profitTarget, countProfitTargets(child) - 1) &&
+                       (childRow[profitComplement] == INFINITE_COST ||
+                        prevRow[profitTarget - profitComplement] == INFINITE_COST ||
+                        childRow[profitComplement] + prevRow[profitTarget - profitComplement] !=
+                            target)) {
+                    ++profitComplement;
+                }
+                assert(profitComplement <= profitTarget);
+
+                const size_t childSelection =
+                    findBestAccessibleSelection(child, accessible, profitComplement);
+                steps.emplace(child, ProfitScenario{ childSelection, profitComplement });
+                profitTarget -= profitComplement;
+            }
+
+            chosen.emplace_back(cluster, selection);
+        }
+
+        return chosen;
+    }
+
+    [[nodiscard]] Host makeBestHost() const
+    {
+        Host host(instance.getCapacity());
+
+        // Index the root's table at all its nodes, which gives the least cost of each profit
+        // target over all its selections, and take the most profitable target that is feasible
+        const size_t root = ClusterTreeInstance::getRootCluster();
+        std::vector<uint64_t> everyNode;
+        std::vector<uint32_t> scratch;
+        makeEveryNodeBits(selections[root], everyNode);
+        const uint32_t *bestRow = findBestAccessibleRow(root, everyNode, scratch);
+
+        size_t profitTarget = countProfitTargets(root) - 1;
+        while (profitTarget > 0 && bestRow[profitTarget] == INFINITE_COST) {
+            --profitTarget;
+        }
+        if (profitTarget == 0) {
+            return host;
+        }
+
+        const ProfitScenario bestScenario{
+            findBestAccessibleSelection(root, everyNode, profitTarget), profitTarget
+        };
+        const auto guests = collectGuests(backtrackSelections(bestScenario));
+        host.addGuests(guests.begin(), guests.end());
+        return host;
+    }
+};
+
+/* The frontier mode of the DP keeps, instead of a cost for every profit target, only the Pareto
+ * frontier of each (n, s, j): the (profit, pageCount) pairs under capacity for which no other pair
+ * has at least the profit for at most the pages. Frontiers are sorted by increasing profit, and so
+ * also by increasing page count.*/
+static constexpr uint32_t NO_POINT = std::numeric_limits<uint32_t>::max();
+
+struct FrontierPoint
 {
-    const size_t root = ClusterTreeInstance::getRootCluster();
-    const size_t rootDegree = instance.getClusterChildren(root).size();
+    size_t profit;
+    uint32_t pageCount;
+    uint32_t prevPoint;   // the point of frontier[n, s, j - 1] this point extends
+    uint32_t childPoint;  // the point of child j's accessible frontier added, or NO_POINT if none
+};
 
-    size_t bestProfit = 0;
-    std::optional<GuestSelection> bestProfitCost;
+/* A point of the best frontier over the selections within an accessible set of nodes of a cluster,
+ * which is the point `point` of frontier[n, selection, deg(n)]*/
+struct AccessiblePoint
+{
+    size_t profit;
+    uint32_t pageCount;
+    size_t selection;
+    uint32_t point;
+};
+
+/* Reduces a set of points to its Pareto frontier in increasing profit order. Among points with the
+ * same profit and page count, the earliest one is kept.*/
+template <typename Point>
+static void reduceToFrontier(std::vector<Point> &points)
+{
+    std::ranges::stable_sort(points, [](const Point &a, const Point &b) {
+        return a.profit != b.profit ? a.profit > b.profit : a.pageCount < b.pageCount;
+    });
 
-    for (auto &[key, value] : costs) {
-        if (key.cluster == root && key.childCount == rootDegree && key.profitTarget > bestProfit &&
-            value.pageCount <= instance.getCapacity()) {
-            bestProfit = key.profitTarget;
-            bestProfitCost = std::move(value);
+    size_t kept = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (kept == 0 || points[i].pageCount < points[kept - 1].pageCount) {
+            points[kept++] = points[i];
         }
     }
+    points.resize(kept);
+    std::ranges::reverse(points);
+}
 
-    return bestProfitCost;
+template <typename Point>
+static size_t countFrontierBytes(const std::vector<std::vector<Point>> &frontiers)
+{
+    size_t bytes = frontiers.capacity() * sizeof(std::vector<Point>);
+    for (const auto &frontier : frontiers) {
+        bytes += frontier.capacity() * sizeof(Point);
+    }
+    return bytes;
 }
 
-Host maximiseOneHostByClusterTree(
-    const ClusterTreeInstance &instance,
-    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits)
+struct ClusterTreeFrontierDp : ClusterTreeDpBase
 {
-    std::unordered_map<ProfitOption, GuestSelection,
-                       decltype([](const ProfitOption &k) { return k.hash(); })>
-        costs;
+    // finalFrontiers[n][s] is the frontier of (n, s, deg(n)). An exhaustive cluster frees them
+    // once it has built its accessible frontiers, while a wide cluster keeps them for its parent.
+    std::vector<std::vector<std::vector<FrontierPoint>>> finalFrontiers;
 
-    // The profit upper bound at each subtree is the sum of the profits in its leaves
-    std::unordered_map<size_t, size_t> profitUpperBounds;
+    // accessibleFrontiers[n][a] is the best frontier over the submasks of a, for exhaustive n
+    std::vector<std::vector<std::vector<AccessiblePoint>>> accessibleFrontiers;
+
+    ClusterTreeFrontierDp(const FrozenClusterTreeInstance &instance,
+                          const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
+                          const size_t exhaustiveWidth)
+        : ClusterTreeDpBase(instance, profits, exhaustiveWidth),
+          finalFrontiers(instance.getClusterCount()),
+          accessibleFrontiers(instance.getClusterCount())
+    {
+    }
+
+    void prepareCluster(const size_t cluster)
+    {
+        prepareSelections(cluster);
+
+        countTableBytes(countFrontierBytes(finalFrontiers[cluster]), 0);
+        finalFrontiers[cluster].assign(countSelections(cluster), {});
+        countTableBytes(0, countFrontierBytes(finalFrontiers[cluster]));
+    }
+
+    /* The best frontier over the child's selections within the accessible nodes. A wide child has
+     * no table for this, so its candidates' frontiers are merged into `scratch`.*/
+    const std::vector<AccessiblePoint> &
+    findBestAccessibleFrontier(const size_t child, const std::vector<uint64_t> &accessible,
+                               std::vector<AccessiblePoint> &scratch) const
+    {
+        const ClusterSelections &childSelections = selections[child];
+        if (childSelections.exhaustive) {
+            return accessibleFrontiers[child][accessible.front()];
+        }
+
+        scratch.clear();
+        for (size_t selection = 0; selection < childSelections.count(); ++selection) {
+            if (!childSelections.isSubsetOf(selection, accessible)) {
+                continue;
+            }
+            const auto &finalFrontier = finalFrontiers[child][selection];
+            for (uint32_t point = 0; point < finalFrontier.size(); ++point) {
+                scratch.push_back({ finalFrontier[point].profit, finalFrontier[point].pageCount,
+                                    selection, point });
+            }
+        }
+        reduceToFrontier(scratch);
+        return scratch;
+    }
+
+    /* Computes the frontier of (n, s, j) for every j of one selection s into `frontiers`*/
+    void computeSelectionFrontiers(const size_t cluster, const size_t selection,
+                                   std::vector<std::vector<FrontierPoint>> &frontiers,
+                                   std::vector<uint64_t> &accessible,
+                                   std::vector<AccessiblePoint> &scratch) const
+    {
+        const auto curChildren = instance.getClusterChildren(cluster);
+        const ClusterSelections &curSelections = selections[cluster];
+
+        uint64_t maskWord;
+        const uint64_t *curBits = curSelections.bitsOf(selection, maskWord);
+        const size_t curPageCount = curSelections.pageCounts[selection];
+
+        frontiers.resize(curChildren.size() + 1);
+        for (auto &frontier : frontiers) {
+            frontier.clear();
+        }
+
+        // Initialise: the selection alone, if it fits
+        if (curPageCount <= capacity) {
+            frontiers[0].push_back({ selectionProfits[cluster][selection],
+                                     static_cast<uint32_t>(curPageCount), NO_POINT, NO_POINT });
+        }
+
+        for (size_t j = 1; j <= curChildren.size(); ++j) {
+            const auto &prevFrontier = frontiers[j - 1];
+            auto &curFrontier = frontiers[j];
+
+            const size_t newChild = curChildren[j - 1];
+            makeAccessibleChildrenBits(selections[newChild], curBits, accessible);
+            const auto &childFrontier = findBestAccessibleFrontier(newChild, accessible, scratch);
+
+            // Either take nothing more from the new child, or extend a point with one of its
+            // points, then keep what is not dominated
+            for (uint32_t a = 0; a < prevFrontier.size(); ++a) {
+                curFrontier.push_back(
+                    { prevFrontier[a].profit, prevFrontier[a].pageCount, a, NO_POINT });
+            }
+            for (uint32_t a = 0; a < prevFrontier.size(); ++a) {
+                for (uint32_t b = 0; b < childFrontier.size(); ++b) {
+                    const size_t pageCount = prevFrontier[a].pageCount + childFrontier[b].pageCount;
+                    // Page counts increase along the child's frontier
+                    if (pageCount > capacity) {
+                        break;
+                    }
+                    if (childFrontier[b].profit == 0) {
+                        continue;
+                    }
+                    curFrontier.push_back({ prevFrontier[a].profit + childFrontier[b].profit,
+                                            static_cast<uint32_t>(pageCount), a, b });
+                }
+            }
+            reduceToFrontier(curFrontier);
+        }
+    }
+
+    void fillCostRows(const size_t cluster, const size_t selectionsBegin,
+                      const size_t selectionsEnd)
+    {
+        std::vector<std::vector<FrontierPoint>> frontiers;
+        std::vector<uint64_t> accessible;
+        std::vector<AccessiblePoint> scratch;
+
+        size_t filledBytes = 0;
+        for (size_t curSelection = selectionsBegin; curSelection < selectionsEnd; ++curSelection) {
+            computeSelectionFrontiers(cluster, curSelection, frontiers, accessible, scratch);
+
+            auto &finalFrontier = finalFrontiers[cluster][curSelection];
+            finalFrontier.assign(frontiers.back().begin(), frontiers.back().end());
+            filledBytes += finalFrontier.capacity() * sizeof(FrontierPoint);
+        }
+        countTableBytes(0, filledBytes);
+    }
+
+    void finishCluster(const size_t cluster)
+    {
+        if (!selections[cluster].exhaustive) {
+            return;
+        }
+
+        const size_t nodeCount = instance.getClusterNodes(cluster).size();
+        std::vector<std::vector<AccessiblePoint>> best(countSelections(cluster));
+
+        for (uint64_t mask = 0; mask < countSelections(cluster); ++mask) {
+            const auto &finalFrontier = finalFrontiers[cluster][mask];
+            for (uint32_t point = 0; point < finalFrontier.size(); ++point) {
+                best[mask].push_back(
+                    { finalFrontier[point].profit, finalFrontier[point].pageCount, mask, point });
+            }
+        }
+
+        // The subset-min (zeta) transform, with frontier union in place of min
+        for (size_t bit = 0; bit < nodeCount; ++bit) {
+            for (uint64_t mask = 0; mask < countSelections(cluster); ++mask) {
+                if (!(mask & 1ULL << bit)) {
+                    continue;
+                }
+                // Put the lower mask's points first, so that ties keep the lower mask
+                std::vector<AccessiblePoint> merged = best[mask ^ 1ULL << bit];
+                merged.insert(merged.end(), best[mask].begin(), best[mask].end());
+                reduceToFrontier(merged);
+                best[mask] = std::move(merged);
+            }
+        }
+
+        countTableBytes(countFrontierBytes(accessibleFrontiers[cluster]), countFrontierBytes(best));
+        accessibleFrontiers[cluster] = std::move(best);
+
+        // The parent, and reconstruction, only look up the accessible frontiers
+        countTableBytes(countFrontierBytes(finalFrontiers[cluster]), 0);
+        finalFrontiers[cluster] = {};
+    }
+
+    [[nodiscard]] Host makeBestHost() const
+    {
+        Host host(instance.getCapacity());
+
+        // The top of the root's best frontier at all its nodes is the most profitable point over
+        // all its selections, with the fewest pages for its profit
+        const size_t root = ClusterTreeInstance::getRootCluster();
+        std::vector<uint64_t> everyNode;
+        std::vector<AccessiblePoint> scratch;
+        makeEveryNodeBits(selections[root], everyNode);
+        const auto &bestFrontier = findBestAccessibleFrontier(root, everyNode, scratch);
+
+        if (bestFrontier.empty() || bestFrontier.back().profit == 0) {
+            return host;
+        }
+
+        // Follow the points back down, as each records what it was made from. The frontiers of
+        // each selection visited are recomputed from the tables of its children.
+        struct Step
+        {
+            size_t cluster;
+            size_t selection;
+            uint32_t point;
+        };
+
+        std::vector<std::pair<size_t, size_t>> chosen;
+        std::stack<Step> steps;
+        steps.push({ root, bestFrontier.back().selection, bestFrontier.back().point });
+
+        std::vector<std::vector<FrontierPoint>> frontiers;
+        std::vector<uint64_t> accessible;
+
+        while (!steps.empty()) {
+            const auto [cluster, selection, finalPoint] = steps.top();
+            steps.pop();
+
+            computeSelectionFrontiers(cluster, selection, frontiers, accessible, scratch);
+
+            const auto children = instance.getClusterChildren(cluster);
+            uint64_t maskWord;
+            const uint64_t *bits = selections[cluster].bitsOf(selection, maskWord);
+            uint32_t point = finalPoint;
+
+            for (size_t j = children.size(); j > 0; --j) {
+                const FrontierPoint &cur = frontiers[j][point];
+                if (cur.childPoint != NO_POINT) {
+                    const size_t child = children[j - 1];
+                    makeAccessibleChildrenBits(selections[child], bits, accessible);
+                    const AccessiblePoint &childPoint =
+                        findBestAccessibleFrontier(child, accessible, scratch)[cur.childPoint];
+                    steps.push({ child, childPoint.selection, childPoint.point });
+                }
+                point = cur.prevPoint;
+            }
+
+            chosen.emplace_back(cluster, selection);
+        }
+
+        const auto guests = collectGuests(chosen);
+        host.addGuests(guests.begin(), guests.end());
+        return host;
+    }
+};
+
+/* Counts the dirty children of each cluster. Every ancestor of a dirty cluster must be dirty.*/
+static std::vector<size_t> countDirtyChildren(const FrozenClusterTreeInstance &instance,
+                                              const std::vector<bool> &dirtyClusters)
+{
+    std::vector<size_t> dirtyChildCounts(instance.getClusterCount());
+    for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
+        dirtyChildCounts[cluster] = std::ranges::count_if(
+            instance.getClusterChildren(cluster),
+            [&](const size_t child) { return dirtyClusters[child]; });
+    }
+    return dirtyChildCounts;
+}
+
+/* Recomputes the dirty clusters, keeping the tables of the others*/
+template <typename ClusterTreeDpType>
+static void runClusterTreeDp(ClusterTreeDpType &dp, const std::vector<bool> &dirtyClusters)
+{
+    const FrozenClusterTreeInstance &instance = dp.instance;
 
     // Topological sort:
     // Track the number of unvisited children for each cluster
     // We add a cluster to the frontier only once it has 0 unvisited children
     // As we need the cost table to have been computer for all its child entries
-    std::unordered_map<size_t, size_t> unvisitedClusterChildCount;
+    std::vector<size_t> unvisitedClusterChildCount = countDirtyChildren(instance, dirtyClusters);
     std::queue<size_t> clustersToVisit;
 
     for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
-        const size_t childCount = instance.getClusterChildren(cluster).size();
-
-        if ((unvisitedClusterChildCount[cluster] = childCount) == 0) {
+        if (dirtyClusters[cluster] && unvisitedClusterChildCount[cluster] == 0) {
             clustersToVisit.push(cluster);
         }
     }
@@ -224,107 +1287,297 @@ Host maximiseOneHostByClusterTree(
 
         // Decrement the unvisited child count of each parent
         const size_t parent = instance.getClusterParent(cluster);
-        if (--unvisitedClusterChildCount[parent] == 0) {
+        if (cluster != ClusterTreeInstance::getRootCluster() &&
+            --unvisitedClusterChildCount[parent] == 0) {
             clustersToVisit.push(parent);
         }
 
-        const std::vector<size_t> &curNodes = instance.getClusterNodes(cluster);
-        const auto &curChildren = instance.getClusterChildren(cluster);
+        // Begin by considering each selection of nodes from this cluster that the DP keeps
+        dp.prepareCluster(cluster);
+        dp.fillCostRows(cluster, 0, dp.countSelections(cluster));
+        dp.finishCluster(cluster);
+    }
+}
 
-        if (instance.clusterIsLeaf(cluster)) {
-            const auto &guest = instance.getNodeGuest(curNodes.front());
-            profitUpperBounds[cluster] = profits.at(guest);
-        }
-        else {
-            for (const size_t child : curChildren) {
-                profitUpperBounds[cluster] += profitUpperBounds.at(child);
+template <typename ClusterTreeDpType>
+static void runClusterTreeDpInParallel(ClusterTreeDpType &dp,
+                                       const std::vector<bool> &dirtyClusters,
+                                       WorkStealingPool &pool)
+{
+    const FrozenClusterTreeInstance &instance = dp.instance;
+    const size_t root = ClusterTreeInstance::getRootCluster();
+    const size_t threadCount = pool.getThreadCount();
+
+    // A cluster is ready once all its dirty children are finished, and finished once all its
+    // chunks of rows are filled, so whichever task completes the last dependency schedules the
+    // next step
+    std::vector<std::atomic<size_t>> unfinishedChildCounts(instance.getClusterCount());
+    std::vector<std::atomic<size_t>> unfilledChunkCounts(instance.getClusterCount());
+
+    std::function<void(size_t)> scheduleCluster;
+    scheduleCluster = [&](const size_t cluster) {
+        pool.submit([&, cluster] {
+            dp.prepareCluster(cluster);
+
+            // Split the rows into a few chunks per thread, so that idle threads can steal them
+            const size_t selectionCount = dp.countSelections(cluster);
+            const size_t chunkSize = std::max<size_t>(1, selectionCount / (4 * threadCount));
+            const size_t chunkCount = (selectionCount + chunkSize - 1) / chunkSize;
+            unfilledChunkCounts[cluster] = chunkCount;
+
+            for (size_t begin = 0; begin < selectionCount; begin += chunkSize) {
+                const size_t end = std::min(selectionCount, begin + chunkSize);
+
+                pool.submit([&, cluster, begin, end] {
+                    dp.fillCostRows(cluster, begin, end);
+                    if (unfilledChunkCounts[cluster].fetch_sub(1) != 1) {
+                        return;
+                    }
+
+                    dp.finishCluster(cluster);
+
+                    const size_t parent = instance.getClusterParent(cluster);
+                    if (cluster != root && unfinishedChildCounts[parent].fetch_sub(1) == 1) {
+                        scheduleCluster(parent);
+                    }
+                });
             }
+        });
+    };
+
+    const std::vector<size_t> dirtyChildCounts = countDirtyChildren(instance, dirtyClusters);
+    for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
+        unfinishedChildCounts[cluster] = dirtyChildCounts[cluster];
+    }
+    for (size_t cluster = 0; cluster < instance.getClusterCount(); ++cluster) {
+        if (dirtyClusters[cluster] && dirtyChildCounts[cluster] == 0) {
+            scheduleCluster(cluster);
         }
+    }
 
-        assert(curNodes.size() < 64);
-        // Begin by considering every one of 2^(node count) choices of nodes from this cluster
-        for (uint64_t curMask = 0; curMask < 1ULL << curNodes.size(); ++curMask) {
-            const auto [curSelection, curSelectionPages] =
-                selectNodesByMask(instance, curNodes, curMask);
+    pool.wait();
+}
 
-            size_t profitMade = 0;
-            for (const size_t node : curSelection) {
-                if (instance.nodeIsLeaf(node)) {
-                    profitMade += profits.at(instance.getNodeGuest(node));
-                }
+/* Runs the DP on the pool if there is one, or sequentially otherwise*/
+template <typename ClusterTreeDpType>
+static void runDirtyClusters(ClusterTreeDpType &dp, const std::vector<bool> &dirtyClusters,
+                             WorkStealingPool *pool)
+{
+    if (pool != nullptr) {
+        runClusterTreeDpInParallel(dp, dirtyClusters, *pool);
+    }
+    else {
+        runClusterTreeDp(dp, dirtyClusters);
+    }
+}
+
+template <typename ClusterTreeDpType>
+static Host maximiseOneHostByClusterTreeDp(
+    const FrozenClusterTreeInstance &instance,
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits, const size_t threadCount,
+    const size_t exhaustiveWidth, size_t *peakTableBytes)
+{
+    ClusterTreeDpType dp(instance, profits, exhaustiveWidth);
+    const std::vector<bool> dirtyClusters(instance.getClusterCount(), true);
+    if (threadCount > 1) {
+        WorkStealingPool pool(threadCount);
+        runDirtyClusters(dp, dirtyClusters, &pool);
+    }
+    else {
+        runDirtyClusters(dp, dirtyClusters, nullptr);
+    }
+    if (peakTableBytes != nullptr) {
+        *peakTableBytes = dp.peakTableBytes.load();
+    }
+
+    return dp.makeBestHost();
+}
+
+/* The unit K = epsilon * maxProfit / n that profits are rounded down to a whole number of, where n
+ * is the number of guests with any profit. A selection that is best under the rounded profits
+ * loses less than K per guest against the true best, so less than epsilon * maxProfit <=
+ * epsilon * OPT overall, as long as the most profitable guest fits on a host by itself. No rounded
+ * profit exceeds n / epsilon, so their total, which is the profit dimension of the DP tables, does
+ * not exceed n^2 / epsilon. K is never below 1, since profits are whole already; the total then
+ * stays below n * maxProfit < n^2 / epsilon unscaled, and unit profits are never scaled at all.*/
+static double
+calculateProfitUnit(const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
+                    const double epsilon)
+{
+    int maxProfit = 0;
+    size_t profitableCount = 0;
+    for (const int profit : profits | std::views::values) {
+        maxProfit = std::max(maxProfit, profit);
+        profitableCount += profit > 0;
+    }
+
+    if (profitableCount == 0) {
+        return 1;
+    }
+    return std::max(1.0, epsilon * maxProfit / static_cast<double>(profitableCount));
+}
+
+static std::unordered_map<std::shared_ptr<const Guest>, int>
+scaleProfits(const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
+             const double unit)
+{
+    if (unit == 1) {
+        return profits;
+    }
+
+    std::unordered_map<std::shared_ptr<const Guest>, int> scaledProfits;
+    for (const auto &[guest, profit] : profits) {
+        scaledProfits.emplace(guest, static_cast<int>(std::floor(profit / unit)));
+    }
+    return scaledProfits;
+}
+
+Host maximiseOneHostByClusterTree(
+    const ClusterTreeInstance &instance,
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits, const size_t threadCount,
+    const ClusterTreeDpMode mode, const double epsilon, const size_t exhaustiveWidth,
+    size_t *peakTableBytes)
+{
+    if (epsilon > 0) {
+        return maximiseOneHostByClusterTree(
+            instance, scaleProfits(profits, calculateProfitUnit(profits, epsilon)), threadCount,
+            mode, 0, exhaustiveWidth, peakTableBytes);
+    }
+
+    const FrozenClusterTreeInstance frozenInstance(instance);
+
+    switch (mode) {
+        case CLUSTER_TREE_DP_FRONTIER:
+            return maximiseOneHostByClusterTreeDp<ClusterTreeFrontierDp>(
+                frozenInstance, profits, threadCount, exhaustiveWidth, peakTableBytes);
+        case CLUSTER_TREE_DP_DENSE:
+        default:
+            return maximiseOneHostByClusterTreeDp<ClusterTreeDp>(
+                frozenInstance, profits, threadCount, exhaustiveWidth, peakTableBytes);
+    }
+}
+
+struct ClusterTreeMaximiser::State
+{
+    // Frozen once, and shared by every call
+    const FrozenClusterTreeInstance instance;
+    const ClusterTreeDpMode mode;
+    const double epsilon;
+    const size_t exhaustiveWidth;
+
+    // Made once if more than one thread is asked for, so that its threads serve every call
+    const std::unique_ptr<WorkStealingPool> pool;
+
+    // The unit profits are scaled by, fixed on the first call so that later calls only change the
+    // scaled profits of the guests whose profits changed
+    std::optional<double> profitUnit;
+
+    // The profits the tables were last computed for, after any scaling. The DP refers to these.
+    std::unordered_map<std::shared_ptr<const Guest>, int> profits;
+    std::unordered_map<std::shared_ptr<const Guest>, size_t> leafClusters;
+
+    // Only the DP of the chosen mode is made, on the first call
+    std::unique_ptr<ClusterTreeDp> denseDp;
+    std::unique_ptr<ClusterTreeFrontierDp> frontierDp;
+
+    State(const ClusterTreeInstance &instance, const size_t threadCount,
+          const ClusterTreeDpMode mode, const double epsilon, const size_t exhaustiveWidth)
+        : instance(instance),
+          mode(mode),
+          epsilon(epsilon),
+          exhaustiveWidth(exhaustiveWidth),
+          pool(threadCount > 1 ? std::make_unique<WorkStealingPool>(threadCount) : nullptr)
+    {
+        for (const size_t leaf : instance.getLeafNodes()) {
+            leafClusters.emplace(instance.getNodeGuest(leaf), instance.getNodeCluster(leaf));
+        }
+    }
+
+    /* Records the new profits, and marks dirty every cluster on the path from the leaf of each
+     * guest whose profit changed to the root*/
+    std::vector<bool>
+    updateProfits(const std::unordered_map<std::shared_ptr<const Guest>, int> &newProfits,
+                  const bool haveTables)
+    {
+        std::vector<bool> dirtyClusters(instance.getClusterCount(), !haveTables);
+
+        for (const auto &[guest, profit] : newProfits) {
+            const auto [it, inserted] = profits.try_emplace(guest, profit);
+            if (!inserted && it->second == profit) {
+                continue;
             }
+            it->second = profit;
 
-            for (size_t profitTarget = 0; profitTarget <= profitUpperBounds[cluster];
-                 ++profitTarget) {
-                // Initialise:
-                // cost[n,s,0,p] = if (sum profit in s) >= p then |union pages in s| else +inf
-                ProfitOption curKey{ cluster, curMask, 0, profitTarget };
-                if (curSelectionPages.size() > instance.getCapacity() ||
-                    profitMade < profitTarget) {
-                    costs[curKey] = GuestSelection();
-                }
-                else {
-                    costs[curKey].setFromSelection(curSelection, curSelectionPages, instance);
-                }
+            const auto leafCluster = leafClusters.find(guest);
+            if (leafCluster == leafClusters.end()) {
+                continue;
+            }
 
-                // Allow taking from the first j children at a time
-                for (size_t j = 1; j <= curChildren.size(); ++j) {
-                    // We will compute cost[n, s, j, p]
-                    curKey = { cluster, curMask, j, profitTarget };
-                    // Try to do better than with j - 1 children
-                    costs[curKey] = costs.at({ cluster, curMask, j - 1, profitTarget });
-
-                    // Only those nodes in the child cluster that have at least one parent in
-                    // the current selection are accessible, as the mask must be over all the
-                    // cluster's nodes
-
-                    // TODO as a performance optimisation, consider computing the subset of viable
-                    // children first, then generate *its* subsets instead
-
-                    const size_t newChild = curChildren[j - 1];
-                    const std::vector<size_t> &newChildNodes = instance.getClusterNodes(newChild);
-                    const size_t accessibleChildrenMask =
-                        makeAccessibleChildrenMask(newChildNodes, curSelection, instance);
-
-                    // Try to make `profitComplement` profit from the newly considered child
-                    // cluster
-                    for (size_t profitComplement = 0;
-                         profitComplement <= std::min(profitTarget, profitUpperBounds.at(newChild));
-                         ++profitComplement) {
-                        const GuestSelection bestChildCost =
-                            findLowestCostAccessibleSelection(
-                                costs, newChild, accessibleChildrenMask, profitComplement, instance)
-                                .value_or(GuestSelection());
-                        const GuestSelection &prevCost =
-                            costs.at({ cluster, curMask, j - 1, profitTarget - profitComplement });
-
-                        if (bestChildCost.pageCount == std::numeric_limits<int>::max() ||
-                            prevCost.pageCount == std::numeric_limits<int>::max()) {
-                            continue;
-                        }
-
-                        const size_t candidatePageCount =
-                            prevCost.pageCount + bestChildCost.pageCount;
-
-                        if (candidatePageCount <= instance.getCapacity() &&
-                            candidatePageCount < costs.at(curKey).pageCount) {
-                            costs[curKey].setFromCombinationOfDisjoint(prevCost, bestChildCost);
-                        }
-                    }
-                }
+            // The parent of the root is itself, which stops the walk once the root is marked
+            for (size_t cluster = leafCluster->second; !dirtyClusters[cluster];
+                 cluster = instance.getClusterParent(cluster)) {
+                dirtyClusters[cluster] = true;
             }
         }
+
+        return dirtyClusters;
     }
 
-    Host host(instance.getCapacity());
+    template <typename ClusterTreeDpType>
+    Host maximiseWith(std::unique_ptr<ClusterTreeDpType> &dp,
+                  const std::unordered_map<std::shared_ptr<const Guest>, int> &newProfits)
+    {
+        const std::vector<bool> dirtyClusters = updateProfits(newProfits, dp != nullptr);
+        if (!dp) {
+            dp = std::make_unique<ClusterTreeDpType>(instance, profits, exhaustiveWidth);
+        }
 
-    const auto bestCost = findMostProfitableScenarioAtRoot(costs, instance);
-    if (!bestCost.has_value()) {
-        return host;
+        runDirtyClusters(*dp, dirtyClusters, pool.get());
+        return dp->makeBestHost();
     }
 
-    host.addGuests(bestCost->guests.begin(), bestCost->guests.end());
-    return host;
+    Host maximise(const std::unordered_map<std::shared_ptr<const Guest>, int> &newProfits)
+    {
+        switch (mode) {
+            case CLUSTER_TREE_DP_FRONTIER:
+                return maximiseWith(frontierDp, newProfits);
+            case CLUSTER_TREE_DP_DENSE:
+            default:
+                return maximiseWith(denseDp, newProfits);
+        }
+    }
+};
+
+ClusterTreeMaximiser::ClusterTreeMaximiser(const ClusterTreeInstance &instance,
+                                           const size_t threadCount, const ClusterTreeDpMode mode,
+                                           const double epsilon, const size_t exhaustiveWidth)
+    : state(std::make_unique<State>(instance, threadCount, mode, epsilon, exhaustiveWidth))
+{
+}
+
+ClusterTreeMaximiser::~ClusterTreeMaximiser() = default;
+
+Host ClusterTreeMaximiser::maximise(
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits)
+{
+    if (state->epsilon > 0) {
+        if (!state->profitUnit.has_value()) {
+            state->profitUnit = calculateProfitUnit(profits, state->epsilon);
+        }
+        return state->maximise(scaleProfits(profits, *state->profitUnit));
+    }
+    return state->maximise(profits);
+}
+
+size_t ClusterTreeMaximiser::getPeakTableBytes() const
+{
+    if (state->denseDp) {
+        return state->denseDp->peakTableBytes.load();
+    }
+    if (state->frontierDp) {
+        return state->frontierDp->peakTableBytes.load();
+    }
+    return 0;
 }
 
-}  // namespace vmp
\ No newline at end of file
+}  // namespace vmp
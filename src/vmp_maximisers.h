@@ -6,87 +6,13 @@
 #include <vmp_commontypes.h>
 
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <ranges>
 
 namespace vmp
 {
 
-static bool next_combination(std::vector<int> &indices, const size_t n)
-{
-    const int k = static_cast<int>(indices.size());
-    for (int i = k - 1; i >= 0; --i) {
-        if (indices[i] >= n - k + i) {
-            continue;
-        }
-        ++indices[i];
-        for (int j = i + 1; j < k; ++j) {
-            indices[j] = indices[j - 1] + 1;
-        }
-        return true;
-    }
-    return false;
-}
-
-/**
- * Finds the most efficient subset of guests to place on a host given a
- * mandatory subset size, accounting for the reward and page sharing within
- * the subset and with the host.
- *
- * @param unplaced the pool of guests to sample
- * @param host the host to place the guests on
- * @param subsetSize the number of guests to place
- * @return the most efficient subset of guests, or `std::nullopt` if no viable subset exists
- */
-static std::optional<std::vector<std::pair<std::shared_ptr<const Guest>, int>>>
-findMostEfficientSubset(const std::unordered_map<std::shared_ptr<const Guest>, int> &unplaced,
-                        const Host &host, int subsetSize)
-{
-    std::vector<std::pair<std::shared_ptr<const Guest>, int>> guests(unplaced.begin(),
-                                                                     unplaced.end());
-    const int guestCount = static_cast<int>(guests.size());
-    subsetSize = std::min(guestCount, subsetSize);
-
-    std::optional<std::vector<std::pair<std::shared_ptr<const Guest>, int>>> bestSubset;
-    double bestSubsetValue = 0.0;
-
-    std::vector<int> indices(subsetSize);
-    std::iota(indices.begin(), indices.end(), 0);
-
-    do {
-        std::vector<std::pair<std::shared_ptr<const Guest>, int>> subset;
-        subset.reserve(subsetSize);
-        for (const int index : indices) {
-            subset.emplace_back(guests[index]);
-        }
-
-        std::vector<std::shared_ptr<const Guest>> candidateView;
-        candidateView.reserve(subsetSize);
-        for (const auto &guest : subset | std::views::keys) {
-            candidateView.push_back(guest);
-        }
-
-        if (!host.accommodatesGuests(candidateView.begin(), candidateView.end())) {
-            continue;
-        }
-
-        const double rewardSum =
-            std::accumulate(subset.begin(), subset.end(), 0.0,
-                            [](double acc, const auto &guest) { return acc + guest.second; });
-
-        const size_t pageCount =
-            host.countPagesWithGuests(candidateView.begin(), candidateView.end());
-        const double subsetValue = rewardSum / static_cast<double>(1 + pageCount);
-
-        if (subsetValue > bestSubsetValue) {
-            bestSubset = std::move(subset);
-            bestSubsetValue = subsetValue;
-        }
-    } while (next_combination(indices, guestCount));
-
-    return bestSubset;
-}
-
 /**
  * Places guests on a single host by always picking the next most valuable set
  * based on the reward and page sharing. See Li, et al. (2009) and Rampersaud &
@@ -102,17 +28,114 @@ Host maximiseOneHostBySubsetEfficiency(
     const std::unordered_map<std::shared_ptr<const Guest>, int> &profits,
     int initialSubsetSize = 1);
 
+/**
+ * How the Cluster Tree DP stores its states.
+ * - `CLUSTER_TREE_DP_DENSE` keeps the least page count for every profit target up to the total
+ *   profit of each subtree, which suits unit profits.
+ * - `CLUSTER_TREE_DP_FRONTIER` keeps only the Pareto frontier of (profit, page count) pairs under
+ *   capacity, so its cost follows the number of non-dominated states rather than the total profit.
+ */
+enum ClusterTreeDpMode
+{
+    CLUSTER_TREE_DP_DENSE = 0,
+    CLUSTER_TREE_DP_FRONTIER
+};
+
+/** The most nodes of a cluster whose selections fit in the 64-bit masks of the cluster-tree DP */
+constexpr size_t MAX_EXHAUSTIVE_CLUSTER_WIDTH = 63;
+
 /**
  * Maximises the number of guests placed on a single host on the Cluster Tree
  * model. See Sinderal, et al. (2011).
  *
+ * With more than one thread, sibling subtrees and the selection rows within a cluster are
+ * computed concurrently on a work-stealing pool; a cluster waits only for its own children.
+ *
+ * Clusters of up to `exhaustiveWidth` nodes, and never more than `MAX_EXHAUSTIVE_CLUSTER_WIDTH`,
+ * are searched over every selection of their nodes, which takes time and memory exponential in
+ * their width. Wider clusters, which may have any number of nodes, are searched over a bounded
+ * beam of promising selections instead, so the host found is then a heuristic rather than an
+ * exact maximum. A smaller `exhaustiveWidth` thus trades exactness for time and memory.
+ *
+ * Each cluster keeps only the table its parent looks up: the best over its selections within each
+ * set of accessible nodes. The states of a selection with fewer than all of its children are
+ * dropped once computed, and recomputed for the few selections that reconstruction visits.
+ *
+ * The DP runs on a `FrozenClusterTreeInstance` made from the instance, whose clusters and nodes lie
+ * in contiguous arrays.
+ *
+ * The DP is pseudo-polynomial in the total profit. With a positive `epsilon`, profits are first
+ * rounded down to whole units of epsilon * maxProfit / n, for the n guests with any profit, so that
+ * no guest's profit exceeds n / epsilon and the total profit, and so the profit dimension of the
+ * tables, does not exceed n^2 / epsilon. The host found then makes at least (1 - epsilon) of the
+ * best profit, provided the most profitable guest fits on a host by itself. A unit below 1 is
+ * raised to 1, so profits already that small, such as the unit profits of
+ * `maximiseByLocalSearch`, are left as they are.
+ *
  * @param instance the instance to maximise
  * @param profits the profit acquired by packing each guest
+ * @param threadCount the number of worker threads to use. Defaults to 1, i.e. sequential.
+ * @param mode how to store the DP states. Defaults to `CLUSTER_TREE_DP_DENSE`.
+ * @param epsilon the approximation parameter. Defaults to 0, i.e. exact.
+ * @param exhaustiveWidth the most nodes of a cluster searched over every selection. Defaults to
+ * `MAX_EXHAUSTIVE_CLUSTER_WIDTH`.
+ * @param peakTableBytes if not null, set to the most bytes held at once by the DP tables. Defaults
+ * to null.
  * @return the maximised host
  */
 Host maximiseOneHostByClusterTree(
     const ClusterTreeInstance &instance,
-    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits);
+    const std::unordered_map<std::shared_ptr<const Guest>, int> &profits, size_t threadCount = 1,
+    ClusterTreeDpMode mode = CLUSTER_TREE_DP_DENSE, double epsilon = 0,
+    size_t exhaustiveWidth = MAX_EXHAUSTIVE_CLUSTER_WIDTH, size_t *peakTableBytes = nullptr);
+
+/**
+ * Maximises guests on a single host on the Cluster Tree model, as `maximiseOneHostByClusterTree`,
+ * but keeps the DP tables between calls. On each call after the first, only the clusters on the
+ * paths from the leaves of guests whose profit changed to the root are recomputed, which suits
+ * `maximiseByLocalSearch`, as it only zeroes the profits of the guests it has just placed.
+ *
+ * The instance is frozen once on construction, so later changes to it are not seen.
+ */
+class ClusterTreeMaximiser
+{
+  public:
+    /**
+     * @param instance the instance to maximise
+     * @param threadCount the number of worker threads to use, which are started once and serve
+     * every call. Defaults to 1, i.e. sequential.
+     * @param mode how to store the DP states. Defaults to `CLUSTER_TREE_DP_DENSE`.
+     * @param epsilon the approximation parameter. Defaults to 0, i.e. exact. The unit profits are
+     * scaled by is fixed on the first call, so that a later call still recomputes only the clusters
+     * whose guests' profits changed; the guarantee of a later call then holds against the most
+     * profitable guest of the first.
+     * @param exhaustiveWidth the most nodes of a cluster searched over every selection. Defaults
+     * to `MAX_EXHAUSTIVE_CLUSTER_WIDTH`.
+     */
+    explicit ClusterTreeMaximiser(const ClusterTreeInstance &instance, size_t threadCount = 1,
+                                  ClusterTreeDpMode mode = CLUSTER_TREE_DP_DENSE,
+                                  double epsilon = 0,
+                                  size_t exhaustiveWidth = MAX_EXHAUSTIVE_CLUSTER_WIDTH);
+    ~ClusterTreeMaximiser();
+
+    ClusterTreeMaximiser(const ClusterTreeMaximiser &) = delete;
+    ClusterTreeMaximiser &operator=(const ClusterTreeMaximiser &) = delete;
+
+    /**
+     * @param profits the profit acquired by packing each guest
+     * @return the maximised host
+     */
+    Host maximise(const std::unordered_map<std::shared_ptr<const Guest>, int> &profits);
+
+    /**
+     * @return the most bytes held at once by the DP tables over every call so far
+     */
+    [[nodiscard]] size_t getPeakTableBytes() const;
+
+  private:
+    struct State;
+    std::unique_ptr<State> state;
+};
 
 /**
  * Maximises the number of guests placed on `allowedHostCount` hosts by using a
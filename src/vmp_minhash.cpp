@@ -0,0 +1,84 @@
+#include <vmp_minhash.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace vmp
+{
+
+/* The SplitMix64 finaliser, a cheap bijective mix of all 64 bits*/
+static uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+MinHasher::MinHasher(const size_t hashCount, const uint64_t seed) : salts(hashCount)
+{
+    for (size_t i = 0; i < hashCount; ++i) {
+        salts[i] = mix(seed + 0x9E3779B97F4A7C15ULL * (i + 1));
+    }
+}
+
+uint64_t MinHasher::hashPage(const uint64_t pageHash, const size_t function) const
+{
+    // Each function salts the page's hash once and remixes it with one multiply
+    const uint64_t salted = (pageHash ^ salts[function]) * 0x9E3779B97F4A7C15ULL;
+    return salted ^ (salted >> 32);
+}
+
+void MinHasher::sign(const std::unordered_set<int> &pages,
+                     const std::span<uint64_t> signature) const
+{
+    assert(signature.size() == salts.size());
+
+    std::ranges::fill(signature, std::numeric_limits<uint64_t>::max());
+    for (const int page : pages) {
+        const uint64_t pageHash = mix(static_cast<uint64_t>(static_cast<uint32_t>(page)));
+        for (size_t i = 0; i < salts.size(); ++i) {
+            signature[i] = std::min(signature[i], hashPage(pageHash, i));
+        }
+    }
+}
+
+std::vector<uint64_t> MinHasher::sign(const std::unordered_set<int> &pages) const
+{
+    std::vector<uint64_t> signature(salts.size());
+    sign(pages, signature);
+    return signature;
+}
+
+size_t MinHasher::getHashCount() const
+{
+    return salts.size();
+}
+
+double MinHasher::estimateSimilarity(const std::span<const uint64_t> signature1,
+                                     const std::span<const uint64_t> signature2)
+{
+    assert(signature1.size() == signature2.size());
+
+    if (signature1.empty()) {
+        return 0.0;
+    }
+
+    size_t agreements = 0;
+    for (size_t i = 0; i < signature1.size(); ++i) {
+        agreements += signature1[i] == signature2[i];
+    }
+    return static_cast<double>(agreements) / static_cast<double>(signature1.size());
+}
+
+void MinHasher::mergeInto(const std::span<uint64_t> signature,
+                          const std::span<const uint64_t> other)
+{
+    assert(signature.size() == other.size());
+
+    for (size_t i = 0; i < signature.size(); ++i) {
+        signature[i] = std::min(signature[i], other[i]);
+    }
+}
+
+}  // namespace vmp
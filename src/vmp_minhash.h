@@ -0,0 +1,59 @@
+#ifndef VMP_MINHASH_H
+#define VMP_MINHASH_H
+
+#include <cstdint>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * Makes MinHash signatures of page sets. A signature holds, for each of a fixed number of hash
+ * functions, the least hash of any page in the set. Two signatures agree at each position with
+ * probability equal to the Jaccard similarity of their sets, and the signature of a union of sets
+ * is the elementwise minimum of theirs.
+ */
+class MinHasher
+{
+  public:
+    /**
+     * @param hashCount the length of each signature
+     * @param seed the seed from which the hash functions are drawn. Defaults to 0.
+     */
+    explicit MinHasher(size_t hashCount, uint64_t seed = 0);
+
+    /**
+     * Writes the signature of a page set
+     *
+     * @param pages the pages to sign
+     * @param signature where to write the signature, of length `getHashCount()`
+     */
+    void sign(const std::unordered_set<int> &pages, std::span<uint64_t> signature) const;
+
+    [[nodiscard]] std::vector<uint64_t> sign(const std::unordered_set<int> &pages) const;
+
+    [[nodiscard]] size_t getHashCount() const;
+
+    /**
+     * @return the fraction of positions at which two signatures of the same length agree, which
+     * estimates the Jaccard similarity of their sets
+     */
+    [[nodiscard]] static double estimateSimilarity(std::span<const uint64_t> signature1,
+                                                   std::span<const uint64_t> signature2);
+
+    /**
+     * Makes `signature` the signature of the union of its set with that of `other`
+     */
+    static void mergeInto(std::span<uint64_t> signature, std::span<const uint64_t> other);
+
+  private:
+    [[nodiscard]] uint64_t hashPage(uint64_t pageHash, size_t function) const;
+
+    std::vector<uint64_t> salts;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_MINHASH_H
@@ -0,0 +1,91 @@
+#include <vmp_minplus.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VMP_MINPLUS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace vmp
+{
+
+static uint32_t addSaturating(const uint32_t x, const uint32_t y)
+{
+    const uint32_t sum = x + y;
+    return sum < x ? INFINITE_COST : sum;
+}
+
+/* Every (min,+) kernel below fixes c and sweeps p, so that the inner loop reads `a` and writes
+ * `out` contiguously. Entries of `b` that are infinite contribute nothing and are skipped. */
+
+static void minPlusConvolveScalar(const uint32_t *a, const size_t aLength, const uint32_t *b,
+                                  const size_t bLength, uint32_t *out, const size_t outLength)
+{
+    for (size_t c = 0; c < std::min(bLength, outLength); ++c) {
+        if (b[c] == INFINITE_COST) {
+            continue;
+        }
+
+        const size_t end = std::min(outLength, aLength + c);
+        for (size_t p = c; p < end; ++p) {
+            out[p] = std::min(out[p], addSaturating(a[p - c], b[c]));
+        }
+    }
+}
+
+#ifdef VMP_MINPLUS_AVX2
+
+__attribute__((target("avx2"))) static void
+minPlusConvolveAvx2(const uint32_t *a, const size_t aLength, const uint32_t *b,
+                    const size_t bLength, uint32_t *out, const size_t outLength)
+{
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+
+    for (size_t c = 0; c < std::min(bLength, outLength); ++c) {
+        if (b[c] == INFINITE_COST) {
+            continue;
+        }
+
+        const __m256i bc = _mm256_set1_epi32(static_cast<int>(b[c]));
+        const size_t end = std::min(outLength, aLength + c);
+
+        size_t p = c;
+        for (; p + 8 <= end; p += 8) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + p - c));
+            const __m256i sum = _mm256_add_epi32(x, bc);
+
+            // The sum wrapped around iff it is below x, in which case saturate it to all ones
+            const __m256i noOverflow = _mm256_cmpeq_epi32(_mm256_min_epu32(sum, x), x);
+            const __m256i saturated = _mm256_or_si256(sum, _mm256_xor_si256(noOverflow, allOnes));
+
+            auto *dst = reinterpret_cast<__m256i *>(out + p);
+            _mm256_storeu_si256(dst, _mm256_min_epu32(_mm256_loadu_si256(dst), saturated));
+        }
+        for (; p < end; ++p) {
+            out[p] = std::min(out[p], addSaturating(a[p - c], b[c]));
+        }
+    }
+}
+
+static bool cpuSupportsAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+void minPlusConvolve(const uint32_t *a, const size_t aLength, const uint32_t *b,
+                     const size_t bLength, uint32_t *out, const size_t outLength)
+{
+#ifdef VMP_MINPLUS_AVX2
+    if (cpuSupportsAvx2()) {
+        minPlusConvolveAvx2(a, aLength, b, bLength, out, outLength);
+        return;
+    }
+#endif
+    minPlusConvolveScalar(a, aLength, b, bLength, out, outLength);
+}
+
+}  // namespace vmp
@@ -0,0 +1,37 @@
+#ifndef VMP_MINPLUS_H
+#define VMP_MINPLUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace vmp
+{
+
+/**
+ * The cost of an infeasible entry in a (min,+) row. Sums saturate here, so an infeasible entry
+ * never becomes feasible by addition.
+ */
+constexpr uint32_t INFINITE_COST = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Accumulates the (min,+) convolution of two cost rows into `out`, i.e. sets
+ *
+ *   out[p] = min(out[p], min { a[p - c] + b[c] : 0 <= c < bLength, 0 <= p - c < aLength })
+ *
+ * for every 0 <= p < outLength, where the sums saturate at `INFINITE_COST`. Uses AVX2 when the
+ * CPU supports it.
+ *
+ * @param a the first row
+ * @param aLength the length of the first row
+ * @param b the second row
+ * @param bLength the length of the second row
+ * @param out the row to accumulate into, which must not alias `a` or `b`
+ * @param outLength the length of the output row
+ */
+void minPlusConvolve(const uint32_t *a, size_t aLength, const uint32_t *b, size_t bLength,
+                     uint32_t *out, size_t outLength);
+
+}  // namespace vmp
+
+#endif  // VMP_MINPLUS_H
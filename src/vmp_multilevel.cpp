@@ -0,0 +1,280 @@
+#include <vmp_multilevel.h>
+
+#include <vmp_solverutils.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <random>
+#include <ranges>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace vmp
+{
+
+/* A level of the coarsening: its guests, and the finer guests each super-guest merged*/
+struct CoarseLevel
+{
+    std::vector<std::shared_ptr<const Guest>> guests;
+    std::unordered_map<std::shared_ptr<const Guest>,
+                       std::pair<std::shared_ptr<const Guest>, std::shared_ptr<const Guest>>>
+        mergedGuests;
+};
+
+static std::shared_ptr<const Guest> mergeGuests(const Guest &guest1, const Guest &guest2)
+{
+    std::unordered_set<int> pages = guest1.pages;
+    pages.insert(guest2.pages.begin(), guest2.pages.end());
+
+    // Only weighted pages, e.g. page classes, need their weights carried over
+    std::unordered_map<int, size_t> pageWeights;
+    for (const int page : pages) {
+        const size_t weight =
+            guest1.pages.contains(page) ? guest1.getPageWeight(page) : guest2.getPageWeight(page);
+        if (weight != 1) {
+            pageWeights.emplace(page, weight);
+        }
+    }
+    return std::make_shared<const Guest>(pages, pageWeights);
+}
+
+/* Merges each guest with the unmatched guest it shares the most pages with, if the two fit on a
+ * host together. Each page offers a uniform sample of at most `neighbourLimit` of its guests.*/
+static CoarseLevel coarsen(const std::vector<std::shared_ptr<const Guest>> &guests,
+                           const size_t capacity, const size_t neighbourLimit)
+{
+    struct PageHolders
+    {
+        std::vector<size_t> sample;
+        size_t seen = 0;
+    };
+
+    // Reservoir sampling, seeded so that the same instance always coarsens the same way
+    std::mt19937_64 rng(guests.size());
+    std::unordered_map<int, PageHolders> pageGuests;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        for (const int page : guests[guest]->pages) {
+            auto &holders = pageGuests[page];
+            if (holders.sample.size() < neighbourLimit) {
+                holders.sample.push_back(guest);
+            }
+            else if (const size_t slot = rng() % (holders.seen + 1); slot < neighbourLimit) {
+                holders.sample[slot] = guest;
+            }
+            ++holders.seen;
+        }
+    }
+
+    constexpr size_t noMatch = std::numeric_limits<size_t>::max();
+    std::vector<size_t> matches(guests.size(), noMatch);
+    std::unordered_map<size_t, size_t> sharedCounts;
+
+    CoarseLevel level;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        if (matches[guest] != noMatch) {
+            continue;
+        }
+
+        sharedCounts.clear();
+        for (const int page : guests[guest]->pages) {
+            for (const size_t neighbour : pageGuests[page].sample) {
+                if (neighbour != guest && matches[neighbour] == noMatch) {
+                    sharedCounts[neighbour] += guests[guest]->getPageWeight(page);
+                }
+            }
+        }
+
+        size_t best = noMatch;
+        size_t bestShared = 0;
+        for (const auto &[neighbour, shared] : sharedCounts) {
+            const size_t mergedCount = guests[guest]->getUniquePageCount() +
+                                       guests[neighbour]->getUniquePageCount() - shared;
+            if (mergedCount > capacity) {
+                continue;
+            }
+            if (shared > bestShared || (shared == bestShared && neighbour < best)) {
+                best = neighbour;
+                bestShared = shared;
+            }
+        }
+
+        if (best == noMatch) {
+            matches[guest] = guest;
+            level.guests.push_back(guests[guest]);
+            continue;
+        }
+
+        matches[guest] = best;
+        matches[best] = guest;
+        const auto merged = mergeGuests(*guests[guest], *guests[best]);
+        level.guests.push_back(merged);
+        level.mergedGuests.emplace(merged, std::make_pair(guests[guest], guests[best]));
+    }
+    return level;
+}
+
+/* Replaces each super-guest on the hosts with the guests it merged*/
+static void uncoarsen(std::vector<std::shared_ptr<Host>> &hosts, const CoarseLevel &level)
+{
+    for (const auto &host : hosts) {
+        std::vector<std::shared_ptr<const Guest>> merged;
+        for (const auto &guest : host->getGuests()) {
+            if (level.mergedGuests.contains(guest)) {
+                merged.push_back(guest);
+            }
+        }
+        for (const auto &guest : merged) {
+            const auto &[guest1, guest2] = level.mergedGuests.at(guest);
+            host->addGuest(guest1);
+            host->addGuest(guest2);
+            host->removeGuest(guest);
+        }
+    }
+}
+
+/* The page-sharing gain of moving a guest to another host: the weight of the pages only it holds
+ * on its host, which the move frees, less that of its pages the target lacks, which the move adds*/
+static std::optional<std::pair<long long, size_t>>
+findBestMove(const std::vector<std::shared_ptr<Host>> &hosts, const DecantingIndex &index,
+             const Guest &guest, const size_t source)
+{
+    long long freed = 0;
+    for (const int page : guest.pages) {
+        if (hosts[source]->getPageFrequency(page) == 1) {
+            freed += static_cast<long long>(guest.getPageWeight(page));
+        }
+    }
+
+    // Only a host sharing a page can gain from the move, as any other would take every page
+    std::optional<std::pair<long long, size_t>> best;
+    for (const size_t target : index.findHostsSharingPages(guest.pages)) {
+        if (target == source) {
+            continue;
+        }
+        const size_t added = guest.getUniquePageCount() - guest.countUniquePagesOn(*hosts[target]);
+        if (hosts[target]->getUniquePageCount() + added > hosts[target]->getCapacity()) {
+            continue;
+        }
+        const long long gain = freed - static_cast<long long>(added);
+        if (gain > 0 && (!best.has_value() || gain > best->first)) {
+            best.emplace(gain, target);
+        }
+    }
+    return best;
+}
+
+/* Refines a packing in the style of Fiduccia-Mattheyses: moves are made in order of their
+ * page-sharing gain, highest first, and each guest moves at most once a pass, after which the
+ * gains of the guests sharing pages with it on the hosts it left and joined are updated. Only
+ * moves of positive gain are made, so each lowers the total weight of the pages on the hosts, and
+ * passes are run until one moves nothing, or `maxPasses` have run.*/
+static void refineBySharingGain(std::vector<std::shared_ptr<Host>> &hosts, const size_t maxPasses)
+{
+    DecantingIndex index(hosts);
+    std::unordered_map<std::shared_ptr<const Guest>, size_t> guestHosts;
+    for (size_t host = 0; host < hosts.size(); ++host) {
+        index.admitHost(host);
+        for (const auto &guest : hosts[host]->getGuests()) {
+            guestHosts.emplace(guest, host);
+        }
+    }
+
+    using Move = std::pair<long long, std::shared_ptr<const Guest>>;
+    const auto compareGains = [](const Move &a, const Move &b) { return a.first < b.first; };
+
+    for (size_t pass = 0; pass < maxPasses; ++pass) {
+        std::priority_queue<Move, std::vector<Move>, decltype(compareGains)> moves(compareGains);
+        std::unordered_set<std::shared_ptr<const Guest>> moved;
+
+        const auto queueMove = [&](const std::shared_ptr<const Guest> &guest) {
+            if (const auto best = findBestMove(hosts, index, *guest, guestHosts.at(guest))) {
+                moves.emplace(best->first, guest);
+            }
+        };
+        for (const auto &guest : guestHosts | std::views::keys) {
+            queueMove(guest);
+        }
+
+        while (!moves.empty()) {
+            const auto [gain, guest] = moves.top();
+            moves.pop();
+            if (moved.contains(guest)) {
+                continue;
+            }
+
+            // The gain may have fallen since it was queued, in which case it waits its turn again
+            const size_t source = guestHosts.at(guest);
+            const auto best = findBestMove(hosts, index, *guest, source);
+            if (!best.has_value()) {
+                continue;
+            }
+            if (best->first < gain) {
+                moves.emplace(best->first, guest);
+                continue;
+            }
+
+            const size_t target = best->second;
+            index.moveGuest(guest, source, target);
+            guestHosts[guest] = target;
+            moved.insert(guest);
+
+            for (const size_t host : { source, target }) {
+                for (const auto &neighbour : hosts[host]->getGuests()) {
+                    if (!moved.contains(neighbour) && guestsHaveSharedPage(*neighbour, *guest)) {
+                        queueMove(neighbour);
+                    }
+                }
+            }
+        }
+
+        if (moved.empty()) {
+            break;
+        }
+    }
+    std::erase_if(hosts, [](const auto &host) { return host->getGuests().empty(); });
+}
+
+Packing solveByMultilevel(const GeneralInstance &instance,
+                          const std::function<Packing(const GeneralInstance &)> &coarseSolver,
+                          const size_t coarsestGuestCount, const size_t neighbourLimit,
+                          const size_t refinementPasses)
+{
+    std::vector<CoarseLevel> levels;
+    const std::vector<std::shared_ptr<const Guest>> *guests = &instance.getGuests();
+
+    // Coarsening stops once a level merges too few guests to be worth another
+    while (guests->size() > coarsestGuestCount) {
+        CoarseLevel level = coarsen(*guests, instance.getCapacity(), neighbourLimit);
+        if (level.mergedGuests.size() * 20 < guests->size()) {
+            break;
+        }
+        levels.push_back(std::move(level));
+        guests = &levels.back().guests;
+    }
+
+    // Super-guests that fill most of a host stop merging, so the coarsest level may still be large.
+    // It is then packed in chunks, so that the solver's time stays linear in the number of chunks.
+    std::vector<std::shared_ptr<Host>> hosts;
+    for (size_t begin = 0; begin < guests->size(); begin += coarsestGuestCount) {
+        const size_t end = std::min(begin + coarsestGuestCount, guests->size());
+        Packing chunkPacking = coarseSolver(GeneralInstance(
+            instance.getCapacity(), { guests->begin() + begin, guests->begin() + end }));
+        std::ranges::move(chunkPacking.getHosts(), std::back_inserter(hosts));
+    }
+    if (guests->size() > coarsestGuestCount) {
+        refineBySharingGain(hosts, refinementPasses);
+        decantGuestsByIndex(hosts, PARTITION_ALL_TOGETHER);
+    }
+
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        uncoarsen(hosts, *level);
+        refineBySharingGain(hosts, refinementPasses);
+        decantGuestsByIndex(hosts, PARTITION_INDIVIDUALLY);
+    }
+
+    return Packing(hosts);
+}
+
+}  // namespace vmp
@@ -0,0 +1,43 @@
+#ifndef VMP_MULTILEVEL_H
+#define VMP_MULTILEVEL_H
+
+#include <vmp_generalinstance.h>
+#include <vmp_packing.h>
+
+#include <functional>
+
+namespace vmp
+{
+
+/**
+ * Solves VM-PACK in the style of multilevel graph partitioning, for instances too large for the
+ * greedy solvers. The instance is coarsened level by level, each time merging pairs of guests that
+ * share many pages into super-guests holding the pages of both, as long as those fit on a host.
+ * The coarsest level is packed by the given solver, and the packing is then carried back down the
+ * levels, replacing each super-guest with the two guests it merged, which hold the same pages.
+ * Each level is refined in the style of Fiduccia-Mattheyses, by moving guests between hosts in
+ * order of their page-sharing gain: the weight of the pages only the guest holds on its host, less
+ * that of its pages the other host lacks. Only moves of positive gain are made, and each guest
+ * moves at most once a pass, so each pass lowers the total weight of the pages on the hosts. The
+ * level is then decanted by moving single guests to earlier hosts with `decantGuestsByIndex`.
+ *
+ * Pairs are matched by the pages they share, among a uniform sample of at most `neighbourLimit`
+ * guests per page, so each level, and with it the whole, takes time near-linear in the number of
+ * pages of the guests.
+ *
+ * @param instance the instance to solve
+ * @param coarseSolver the solver with which to pack the coarsest level, e.g. `solveByEfficiency`
+ * @param coarsestGuestCount the number of guests at which to stop coarsening. Defaults to 1000.
+ * @param neighbourLimit the most guests holding each page to consider matching a guest with.
+ *        Defaults to 32.
+ * @param refinementPasses the most refinement passes to run at each level. Defaults to 4.
+ * @return a valid packing, if the solver gives valid packings
+ */
+Packing solveByMultilevel(const GeneralInstance &instance,
+                          const std::function<Packing(const GeneralInstance &)> &coarseSolver,
+                          size_t coarsestGuestCount = 1000, size_t neighbourLimit = 32,
+                          size_t refinementPasses = 4);
+
+}  // namespace vmp
+
+#endif  // VMP_MULTILEVEL_H
@@ -12,10 +12,19 @@ Packing::Packing(const std::vector<std::shared_ptr<Host>> &hosts) : guestCount(0
     }
 }
 
-void Packing::decantGuests()
+void Packing::decantGuests(const DecantingMode mode)
 {
-    using SetGuestIt = std::unordered_set<std::shared_ptr<const Guest>>::iterator;
-    decantGuestByAllPartitioners<SetGuestIt>(hosts);
+    switch (mode) {
+        case DECANTING_THREE_PASS:
+            decantGuestByAllPartitioners(hosts);
+            break;
+        case DECANTING_THREE_PASS_BY_INDEX:
+            decantGuestByAllPartitioners(hosts, true);
+            break;
+        case DECANTING_FIXPOINT:
+            decantGuestsToFixpoint(hosts);
+            break;
+    }
 }
 
 void Packing::addHost(const std::shared_ptr<Host> &host)
@@ -41,4 +50,9 @@ std::vector<std::shared_ptr<Host>> &Packing::getHosts()
     return hosts;
 }
 
+const std::vector<std::shared_ptr<Host>> &Packing::getHosts() const
+{
+    return hosts;
+}
+
 }  // namespace vmp
\ No newline at end of file
@@ -36,6 +36,21 @@ inline std::ostream &operator<<(std::ostream &os, const PackingValidity validity
     return os;
 }
 
+/**
+ * How a packing decants its guests.
+ * - `DECANTING_THREE_PASS` runs each partitioner once over every pair of hosts.
+ * - `DECANTING_THREE_PASS_BY_INDEX` runs each partitioner once over every host, finding targets
+ *   through a `DecantingIndex`. It is much faster on many hosts, but can leave a different packing.
+ * - `DECANTING_FIXPOINT` may also move all of a host's guests to a later host, and retries the
+ *   hosts a move may have affected until no more guests move, or a cap on the rounds is reached.
+ */
+enum DecantingMode
+{
+    DECANTING_THREE_PASS = 0,
+    DECANTING_THREE_PASS_BY_INDEX,
+    DECANTING_FIXPOINT
+};
+
 class Packing
 {
   public:
@@ -81,7 +96,13 @@ class Packing
         return PACKING_OKAY;
     }
 
-    void decantGuests();
+    /**
+     * Moves guests onto earlier hosts where they fit, or with `DECANTING_FIXPOINT` also
+     * whole hosts onto later ones, and removes the hosts left empty
+     *
+     * @param mode how to decant. Defaults to `DECANTING_THREE_PASS`.
+     */
+    void decantGuests(DecantingMode mode = DECANTING_THREE_PASS);
 
     void addHost(const std::shared_ptr<Host> &host);
 
@@ -89,6 +110,7 @@ class Packing
     [[nodiscard]] size_t getHostCount() const;
 
     [[nodiscard]] std::vector<std::shared_ptr<Host>> &getHosts();
+    [[nodiscard]] const std::vector<std::shared_ptr<Host>> &getHosts() const;
 
   private:
     std::vector<std::shared_ptr<Host>> hosts;
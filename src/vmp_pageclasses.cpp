@@ -0,0 +1,109 @@
+#include <vmp_pageclasses.h>
+
+#include <vmp_host.h>
+
+namespace vmp
+{
+
+struct PageClassInstance::PageClasses
+{
+    std::vector<std::shared_ptr<const Guest>> guests;
+    size_t count;
+};
+
+/* Hashes the guests holding a page, which identify its class*/
+struct GuestIndicesHash
+{
+    size_t operator()(const std::vector<size_t> &guests) const
+    {
+        size_t hash = guests.size();
+        for (const size_t guest : guests) {
+            hash ^= std::hash<size_t>{}(guest) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+PageClassInstance::PageClasses
+PageClassInstance::findPageClasses(const std::vector<std::shared_ptr<const Guest>> &guests)
+{
+    // The guests holding each page, in ascending order
+    std::unordered_map<int, std::vector<size_t>> pageGuests;
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        for (const int page : guests[guest]->pages) {
+            pageGuests[page].push_back(guest);
+        }
+    }
+
+    std::unordered_map<std::vector<size_t>, int, GuestIndicesHash> classesOfGuests;
+    std::vector<size_t> classWeights;
+    std::vector<std::unordered_set<int>> guestClasses(guests.size());
+    for (auto &[page, holders] : pageGuests) {
+        const auto [it, inserted] =
+            classesOfGuests.try_emplace(std::move(holders), static_cast<int>(classWeights.size()));
+        if (inserted) {
+            classWeights.push_back(0);
+            for (const size_t guest : it->first) {
+                guestClasses[guest].insert(it->second);
+            }
+        }
+        ++classWeights[it->second];
+    }
+
+    PageClasses result{ {}, classWeights.size() };
+    result.guests.reserve(guests.size());
+    for (auto &classes : guestClasses) {
+        std::unordered_map<int, size_t> weights;
+        for (const int pageClass : classes) {
+            weights.emplace(pageClass, classWeights[pageClass]);
+        }
+        result.guests.push_back(std::make_shared<const Guest>(classes, weights));
+    }
+    return result;
+}
+
+PageClassInstance::PageClassInstance(const GeneralInstance &instance)
+    : PageClassInstance(instance, findPageClasses(instance.getGuests()))
+{
+}
+
+PageClassInstance::PageClassInstance(const GeneralInstance &instance, PageClasses &&classes)
+    : compressed(instance.getCapacity(), classes.guests), classCount(classes.count)
+{
+    const auto &guests = instance.getGuests();
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        originalGuests.emplace(classes.guests[guest], guests[guest]);
+    }
+}
+
+const GeneralInstance &PageClassInstance::getCompressed() const
+{
+    return compressed;
+}
+
+size_t PageClassInstance::getClassCount() const
+{
+    return classCount;
+}
+
+Packing PageClassInstance::expandPacking(const Packing &packing) const
+{
+    std::vector<std::shared_ptr<Host>> hosts;
+    hosts.reserve(packing.getHostCount());
+    for (const auto &host : packing.getHosts()) {
+        auto &expanded = hosts.emplace_back(std::make_shared<Host>(host->getCapacity()));
+        for (const auto &guest : host->getGuests()) {
+            expanded->addGuest(originalGuests.at(guest));
+        }
+    }
+    return Packing(hosts);
+}
+
+Packing solveByPageClasses(const GeneralInstance &instance,
+                           const std::function<Packing(const GeneralInstance &)> &solver)
+{
+    const PageClassInstance compressed(instance);
+    return compressed.expandPacking(solver(compressed.getCompressed()));
+}
+
+}  // namespace vmp
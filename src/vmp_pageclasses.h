@@ -0,0 +1,72 @@
+#ifndef VMP_PAGECLASSES_H
+#define VMP_PAGECLASSES_H
+
+#include <vmp_generalinstance.h>
+#include <vmp_packing.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * An instance whose pages are collapsed into page classes: the sets of pages held by exactly the
+ * same guests, such as the private pages of a guest, or the pages of an image that no guest has
+ * altered. Pages of a class are always on the same hosts, so each is replaced by one page for the
+ * whole class, weighing the number of pages in it, and every guest, host and solver then counts the
+ * same pages on far fewer.
+ *
+ * A packing of the compressed instance is expanded by replacing each host with one holding the
+ * guests its compressed guests stand for, which then holds exactly as many pages.
+ */
+class PageClassInstance
+{
+  public:
+    explicit PageClassInstance(const GeneralInstance &instance);
+
+    /**
+     * @return the instance of a guest of page classes for each guest, in the order given, with the
+     *         same capacity
+     */
+    [[nodiscard]] const GeneralInstance &getCompressed() const;
+
+    /**
+     * @return the number of page classes
+     */
+    [[nodiscard]] size_t getClassCount() const;
+
+    /**
+     * @param packing a packing of the compressed instance
+     * @return a packing of the instance, with a host for each host of the packing
+     */
+    [[nodiscard]] Packing expandPacking(const Packing &packing) const;
+
+  private:
+    struct PageClasses;
+
+    static PageClasses findPageClasses(const std::vector<std::shared_ptr<const Guest>> &guests);
+
+    PageClassInstance(const GeneralInstance &instance, PageClasses &&classes);
+
+    GeneralInstance compressed;
+    size_t classCount;
+    std::unordered_map<std::shared_ptr<const Guest>, std::shared_ptr<const Guest>> originalGuests;
+};
+
+/**
+ * Solves VM-PACK by solving the instance with its pages collapsed into page classes, as in
+ * `PageClassInstance`, and expanding its packing
+ *
+ * @param instance the instance to solve
+ * @param solver the solver with which to pack the compressed instance, e.g. `solveByFirstFit`
+ * @return a valid packing, if the solver gives valid packings
+ */
+Packing solveByPageClasses(const GeneralInstance &instance,
+                           const std::function<Packing(const GeneralInstance &)> &solver);
+
+}  // namespace vmp
+
+#endif  // VMP_PAGECLASSES_H
@@ -0,0 +1,85 @@
+#include <vmp_pagesketch.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace vmp
+{
+
+/* The SplitMix64 finaliser, a cheap bijective mix of all 64 bits*/
+static uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+PageSketch::PageSketch()
+{
+    clear();
+}
+
+void PageSketch::addPage(const int page, const size_t weight)
+{
+    // The top bits of the hash pick the register, and the rest give the rank
+    const uint64_t hash = mix(static_cast<uint64_t>(static_cast<uint32_t>(page)));
+    const size_t index = hash >> (64 - PRECISION);
+    const auto rank = static_cast<uint8_t>(
+        std::min<int>(std::countl_zero(hash << PRECISION), 64 - PRECISION) + 1);
+    registers[index] = std::max(registers[index], rank);
+
+    minWeight = minWeight == 0 ? weight : std::min(minWeight, weight);
+}
+
+void PageSketch::merge(const PageSketch &other)
+{
+    for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+    if (other.minWeight != 0) {
+        minWeight = minWeight == 0 ? other.minWeight : std::min(minWeight, other.minWeight);
+    }
+}
+
+void PageSketch::clear()
+{
+    registers.fill(0);
+    minWeight = 0;
+}
+
+double PageSketch::estimatePageCount() const
+{
+    constexpr auto m = static_cast<double>(REGISTER_COUNT);
+    constexpr double alpha = 0.7213 / (1 + 1.079 / m);
+
+    // 2^-rank for every rank a register can hold
+    static const auto inversePowers = [] {
+        std::array<double, 66 - PRECISION> powers{};
+        for (size_t rank = 0; rank < powers.size(); ++rank) {
+            powers[rank] = std::ldexp(1.0, -static_cast<int>(rank));
+        }
+        return powers;
+    }();
+
+    double sum = 0;
+    size_t zeroCount = 0;
+    for (const uint8_t rank : registers) {
+        sum += inversePowers[rank];
+        zeroCount += rank == 0;
+    }
+
+    // Small sets leave registers empty, and are better estimated by linear counting
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeroCount > 0) {
+        estimate = m * std::log(m / static_cast<double>(zeroCount));
+    }
+    return estimate * static_cast<double>(minWeight);
+}
+
+double PageSketch::getRelativeError()
+{
+    return 1.04 / std::sqrt(static_cast<double>(REGISTER_COUNT));
+}
+
+}  // namespace vmp
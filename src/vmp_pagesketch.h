@@ -0,0 +1,63 @@
+#ifndef VMP_PAGESKETCH_H
+#define VMP_PAGESKETCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace vmp
+{
+
+/**
+ * A HyperLogLog sketch of a page set, which estimates the number of unique pages in the set in
+ * constant space. The sketch of a union of sets is the registerwise maximum of theirs, so the
+ * number of pages a set of guests would have on a host can be estimated by merging their sketches
+ * without counting their pages.
+ *
+ * Each page is hashed once, whatever its weight, and the estimate of unique pages is scaled by the
+ * least weight of any page added, so it is unbiased when every page has the same weight and never
+ * overstates a set of mixed weights. The estimate has a relative standard error of about
+ * `getRelativeError()`.
+ */
+class PageSketch
+{
+  public:
+    static constexpr size_t PRECISION = 8;
+    static constexpr size_t REGISTER_COUNT = size_t{ 1 } << PRECISION;
+
+    PageSketch();
+
+    /**
+     * Adds a page to the set
+     *
+     * @param page the page
+     * @param weight the number of pages the page stands for. Defaults to 1.
+     */
+    void addPage(int page, size_t weight = 1);
+
+    /**
+     * Makes this the sketch of the union of its set with that of `other`
+     */
+    void merge(const PageSketch &other);
+
+    void clear();
+
+    /**
+     * @return the estimated number of unique pages in the set, each counted by the least weight
+     * of any page added
+     */
+    [[nodiscard]] double estimatePageCount() const;
+
+    /**
+     * @return the relative standard error of `estimatePageCount`
+     */
+    [[nodiscard]] static double getRelativeError();
+
+  private:
+    std::array<uint8_t, REGISTER_COUNT> registers;
+    size_t minWeight;  // The least weight of any page added, or 0 if none has been
+};
+
+}  // namespace vmp
+
+#endif  // VMP_PAGESKETCH_H
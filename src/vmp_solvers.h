@@ -3,8 +3,13 @@
 
 #include <cassert>
 #include <iostream>
+#include <iterator>
+#include <vmp_decomposition.h>
+#include <vmp_hostlsh.h>
+#include <vmp_maximisers.h>
 #include <vmp_packing.h>
 #include <vmp_solverutils.h>
+#include <vmp_threadpool.h>
 
 namespace vmp
 {
@@ -43,7 +48,7 @@ Packing solveByNextFit(const InstanceType &instance)
 {
     std::vector<std::shared_ptr<Host>> hosts;
 
-    auto guests = instance.getGuests();
+    const auto &guests = instance.getGuests();
     proceedByNextFit(instance.getCapacity(), guests.begin(), guests.end(), hosts);
 
     return Packing(hosts);
@@ -152,6 +157,94 @@ Packing solveByEfficiency(const InstanceType &instance)
     return Packing(hosts);
 }
 
+/**
+ * Packs `[guestsBegin, guestsEnd)` sequentially as `proceedByEfficiency`, but scores only the hosts
+ * a `HostLshIndex` offers as likely to share pages with each guest, and the last host, rather than
+ * every host. A guest thus costs time in the number of candidates rather than in the number of
+ * hosts, and may miss the host it fits best if that host shares few of its pages.
+ *
+ * Recall falls as hosts gather pages. A host's signature is the minimum of its guests', so it
+ * settles on the least hashes over all of its pages, and a guest only agrees with it on a band if
+ * it holds the pages those came from. A guest sharing most of its pages with a full host, but not
+ * that host's minima, is then found only if the host is the last one, which is the only fallback.
+ *
+ * @tparam GuestIt any iterator type over `std::shared_ptr<const Guest>`
+ * @param capacity the fixed bin capacity
+ * @param guestsBegin the start of guest range
+ * @param guestsEnd the end of guest range
+ * @param hosts the partial hosts vector to use
+ * @param bandCount the number of bands of the index, more of which find more candidates
+ * @param rowsPerBand the number of hashes in each band, more of which find fewer candidates
+ */
+template <SharedPtrIterator<const Guest> GuestIt>
+static void proceedByApproximateEfficiency(size_t capacity, GuestIt guestsBegin,
+                                           GuestIt guestsEnd,
+                                           std::vector<std::shared_ptr<Host>> &hosts,
+                                           const size_t bandCount, const size_t rowsPerBand)
+{
+    HostLshIndex index(bandCount, rowsPerBand);
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        for (const auto &guest : hosts[i]->getGuests()) {
+            index.addToHost(i, index.signGuest(*guest));
+        }
+    }
+
+    for (; guestsBegin != guestsEnd; ++guestsBegin) {
+        const auto &guest = *guestsBegin;
+        const auto signature = index.signGuest(*guest);
+
+        std::vector<size_t> candidates = index.findCandidates(signature);
+        if (!hosts.empty() && (candidates.empty() || candidates.back() != hosts.size() - 1)) {
+            candidates.push_back(hosts.size() - 1);
+        }
+
+        double bestRelSize = guest->getUniquePageCount();
+        std::optional<size_t> bestHost;
+
+        for (const size_t candidate : candidates) {
+            const auto &host = hosts[candidate];
+            if (!host->accommodatesGuest(*guest)) {
+                continue;
+            }
+
+            const double candidateRelSize = calculateRelSize(*guest, host->getPageFrequencies());
+            if (candidateRelSize <= bestRelSize) {
+                bestHost = candidate;
+                bestRelSize = candidateRelSize;
+            }
+        }
+
+        if (!bestHost) {
+            hosts.emplace_back(std::make_shared<Host>(capacity));
+            bestHost = hosts.size() - 1;
+        }
+        hosts[*bestHost]->addGuest(guest);
+        index.addToHost(*bestHost, signature);
+    }
+}
+
+/**
+ * Solves an instance of VM-PACK by "Best Fusion" of Grange, et al. (2021), as
+ * `solveByEfficiency`, but scoring only the candidate hosts of a `HostLshIndex`
+ *
+ * @param instance the instance to solve
+ * @param bandCount the number of bands of the index. Defaults to 16.
+ * @param rowsPerBand the number of hashes in each band. Defaults to 1.
+ * @return a valid packing
+ */
+template <typename InstanceType>
+Packing solveByApproximateEfficiency(const InstanceType &instance, const size_t bandCount = 16,
+                                     const size_t rowsPerBand = 1)
+{
+    std::vector<std::shared_ptr<Host>> hosts;
+
+    const auto &guests = instance.getGuests();
+    proceedByApproximateEfficiency(instance.getCapacity(), guests.begin(), guests.end(), hosts,
+                                   bandCount, rowsPerBand);
+
+    return Packing(hosts);
+}
+
 /**
  * Packs `[guestsBegin, guestsEnd)` sequentially by "Overload-and-Remove" of
  * Grange, et al. (2021), modifying a partial hosts vector
@@ -294,6 +387,8 @@ Packing solveByOpportunityAwareEfficiency(const InstanceType &instance)
 /**
  * Solves VM-PACK by the Sinderal, et al. (2011) greedy algorithm on the tree model.
  *
+ * @tparam GuestIt the iterator type of `std::vector<std::shared_ptr<const Guest>>`, over which the
+ * guests of each extracted subtree are given to the intermediate solver
  * @param instance the instance to solve
  * @param intermediateSolver the intermediate solver with which to pack each extracted subtree
  * @return a valid packing
@@ -304,13 +399,12 @@ Packing solveByTree(const TreeInstance &instance,
                                                std::vector<std::shared_ptr<Host>> &))
 {
     TreeInstance workingInstance = instance;
+    TreeLowerBoundsTracker lowerBounds(workingInstance);
 
     std::vector<std::shared_ptr<Host>> hosts;
 
     while (true) {
-        const auto lowerBounds = calculateAllSubtreeLowerBounds(workingInstance);
-
-        if (lowerBounds.at(TreeInstance::getRootNode()).count == 1) {
+        if (lowerBounds.getBounds(TreeInstance::getRootNode()).count == 1) {
             const auto &guests = workingInstance.getGuests();
             if (guests.empty()) {
                 break;
@@ -323,40 +417,115 @@ Packing solveByTree(const TreeInstance &instance,
             break;
         }
 
-        size_t minNode = std::numeric_limits<size_t>::max();
-        size_t minNodeCount = std::numeric_limits<size_t>::max();
+        const auto minNode = lowerBounds.findMinimalPackableNode();
+        assert(minNode.has_value());
 
-        for (const auto &[node, bounds] : lowerBounds) {
-            if (bounds.count <= 1) {
-                continue;
-            }
+        // Skip the leaves of subtrees already packed
+        std::vector<std::shared_ptr<const Guest>> guestsToPack;
+        std::ranges::copy_if(workingInstance.getSubtreeGuests(*minNode),
+                             std::back_inserter(guestsToPack),
+                             [](const auto &guest) { return guest != nullptr; });
+        intermediateSolver(instance.getCapacity(), guestsToPack.begin(), guestsToPack.end(), hosts);
 
-            const auto &children = workingInstance.getNodeChildren(node);
+        if (*minNode == TreeInstance::getRootNode()) {
+            break;
+        }
 
-            if (!std::ranges::all_of(children, [&](const size_t child) {
-                    return lowerBounds.at(child).count <= 1;
-                })) {
-                continue;
-            }
+        lowerBounds.removeSubtree(*minNode);
+    }
+
+    return Packing(hosts);
+}
+
+/**
+ * Solves VM-PACK by the Sinderal, et al. (2011) greedy algorithm on the tree model, as
+ * `solveByTree`, but packs every subtree that can be packed next at once. Such subtrees are
+ * disjoint, so in each round they are packed concurrently, each into hosts of its own, and then
+ * removed together. The subtrees extracted are the same as `solveByTree`'s, and each is packed
+ * into fresh hosts as the algorithm's guarantee assumes. As no subtree's guests are placed on the
+ * hosts of another while they are packed, the hosts left partly used are then merged with those of
+ * earlier rounds by `combineHosts`, which a host leaves once it is full.
+ *
+ * @tparam GuestIt the iterator type of `std::vector<std::shared_ptr<const Guest>>`, over which the
+ * guests of each extracted subtree are given to the intermediate solver
+ * @param instance the instance to solve
+ * @param intermediateSolver the intermediate solver with which to pack each extracted subtree,
+ * which must be safe to run on disjoint guests and hosts concurrently
+ * @param threadCount the number of worker threads to use
+ * @return a valid packing
+ */
+template <SharedPtrIterator<const Guest> GuestIt>
+Packing solveByTreeInParallel(const TreeInstance &instance,
+                              void (*intermediateSolver)(size_t, GuestIt, GuestIt,
+                                                         std::vector<std::shared_ptr<Host>> &),
+                              const size_t threadCount)
+{
+    TreeInstance workingInstance = instance;
+    TreeLowerBoundsTracker lowerBounds(workingInstance);
+    WorkStealingPool pool(threadCount);
 
-            if (minNode == std::numeric_limits<size_t>::max() || bounds.count < minNodeCount) {
-                minNode = node;
-                minNodeCount = bounds.count;
+    std::vector<std::shared_ptr<Host>> hosts;
+    std::vector<std::shared_ptr<Host>> partialHosts;
+
+    while (true) {
+        if (lowerBounds.getBounds(TreeInstance::getRootNode()).count == 1) {
+            const auto &guests = workingInstance.getGuests();
+            if (guests.empty()) {
+                break;
             }
+
+            Host host(workingInstance.getCapacity());
+            host.addGuests(guests.begin(), guests.end());
+
+            partialHosts.push_back(std::make_shared<Host>(std::move(host)));
+            break;
         }
 
-        assert(minNode != std::numeric_limits<size_t>::max());
+        const std::vector<size_t> nodes = lowerBounds.takePackableNodes();
+        assert(!nodes.empty());
 
-        const auto &guestsToPack = workingInstance.getSubtreeGuests(minNode);
-        intermediateSolver(instance.getCapacity(), guestsToPack.begin(), guestsToPack.end(), hosts);
+        // The guests are gathered up front, as the tour of the instance is not safe to make
+        // concurrently
+        std::vector<std::vector<std::shared_ptr<const Guest>>> guestsToPack(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            std::ranges::copy_if(workingInstance.getSubtreeGuests(nodes[i]),
+                                 std::back_inserter(guestsToPack[i]),
+                                 [](const auto &guest) { return guest != nullptr; });
+        }
+
+        std::vector<std::vector<std::shared_ptr<Host>>> subtreeHosts(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            pool.submit([&, i] {
+                intermediateSolver(instance.getCapacity(), guestsToPack[i].begin(),
+                                   guestsToPack[i].end(), subtreeHosts[i]);
+            });
+        }
+        pool.wait();
 
-        if (minNode == TreeInstance::getRootNode()) {
+        for (auto &packed : subtreeHosts) {
+            std::ranges::move(packed, std::back_inserter(partialHosts));
+        }
+        combineHosts(partialHosts);
+
+        // Full hosts can take no more guests, so are set aside for good
+        const auto fullHosts = std::ranges::partition(partialHosts, [](const auto &host) {
+            return host->getUniquePageCount() < host->getCapacity();
+        });
+        std::ranges::move(fullHosts, std::back_inserter(hosts));
+        partialHosts.erase(fullHosts.begin(), fullHosts.end());
+
+        // The root can only be packed alone, as every other node is then in its subtree
+        if (nodes.front() == TreeInstance::getRootNode()) {
             break;
         }
 
-        workingInstance.removeSubtree(minNode);
+        for (const size_t node : nodes) {
+            lowerBounds.removeSubtree(node);
+        }
     }
 
+    combineHosts(partialHosts);
+    std::ranges::move(partialHosts, std::back_inserter(hosts));
     return Packing(hosts);
 }
 
@@ -395,16 +564,26 @@ Packing solveByLocalSubsetEfficiency(const InstanceType &instance, const int ini
  *
  * @param instance the instance to solve
  * @param decantMaximiserOutputs whether to decant the intermediate maximiser outputs
+ * @param threadCount the number of threads for each run of the DP. Defaults to 1.
+ * @param mode how the DP stores its states. Defaults to `CLUSTER_TREE_DP_DENSE`.
+ * @param epsilon the approximation parameter of the DP. The local search gives every guest a unit
+ * profit, which is never scaled, so this has no effect here. Defaults to 0, i.e. exact.
  * @return a valid packing
  */
 template <typename ClusterTreeInstance>
 Packing solveByLocalClusterTree(const ClusterTreeInstance &instance,
-                                const bool decantMaximiserOutputs = true)
+                                const bool decantMaximiserOutputs = true,
+                                const size_t threadCount = 1,
+                                const ClusterTreeDpMode mode = CLUSTER_TREE_DP_DENSE,
+                                const double epsilon = 0)
 {
+    // Keep the DP tables across the rounds of the local search, which all run on `instance`
+    ClusterTreeMaximiser maximiser(instance, threadCount, mode, epsilon);
+
     auto oneHostMaximiser =
-        [&](const ClusterTreeInstance &inst,
+        [&](const ClusterTreeInstance &,
             const std::unordered_map<std::shared_ptr<const Guest>, int> &profits) {
-            return maximiseOneHostByClusterTree(inst, profits);
+            return maximiser.maximise(profits);
         };
 
     auto nHostMaximiser = [&](const ClusterTreeInstance &inst, const size_t maxHosts) {
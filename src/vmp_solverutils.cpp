@@ -1,12 +1,16 @@
 #include <vmp_solverutils.h>
 
+#include <vmp_frozentreeinstance.h>
 #include <vmp_guest.h>
 #include <vmp_host.h>
 
+#include <array>
+#include <cassert>
 #include <cmath>
 #include <numeric>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace vmp
 {
@@ -18,7 +22,8 @@ double calculateRelSize(const Guest &guest, const std::unordered_map<int, int> &
     for (int page : guest.pages) {
         auto pageIt = pageFreq.find(page);
         const int frequency = (pageIt != pageFreq.end()) ? pageIt->second : 0;
-        total += (frequency > 0) ? (1.0 / frequency) : 1.0;
+        const auto weight = static_cast<double>(guest.getPageWeight(page));
+        total += (frequency > 0) ? (weight / frequency) : weight;
     }
 
     return total;
@@ -46,73 +51,651 @@ double calculateOpportunityAwareEfficiency(const Guest &guest, const std::shared
            std::sqrt(guest.getUniquePageCount());
 }
 
+DisjointSets::DisjointSets(const size_t size) : parents(size), sizes(size, 1)
+{
+    std::iota(parents.begin(), parents.end(), 0);
+}
+
+size_t DisjointSets::find(size_t element)
+{
+    while (parents[element] != element) {
+        parents[element] = parents[parents[element]];
+        element = parents[element];
+    }
+    return element;
+}
+
+bool DisjointSets::unite(const size_t element1, const size_t element2)
+{
+    size_t root1 = find(element1);
+    size_t root2 = find(element2);
+    if (root1 == root2) {
+        return false;
+    }
+
+    if (sizes[root1] < sizes[root2]) {
+        std::swap(root1, root2);
+    }
+    parents[root2] = root1;
+    sizes[root1] += sizes[root2];
+    return true;
+}
+
+GuestPartitioner::GuestPartitioner(const GuestPartitioning partitioning)
+    : partitioning(partitioning), position(0), grouped(false), nextGroup(0)
+{
+}
+
+void GuestPartitioner::rewind()
+{
+    position = 0;
+    nextGroup = 0;
+}
+
+std::optional<std::span<const std::shared_ptr<const Guest>>> GuestPartitioner::next()
+{
+    if (position == guests.size()) {
+        return std::nullopt;
+    }
+
+    size_t end = guests.size();
+    switch (partitioning) {
+        case PARTITION_ALL_TOGETHER:
+            break;
+        case PARTITION_CONNECTED_TOGETHER:
+            if (!grouped) {
+                groupConnectedGuests();
+            }
+            end = groupEnds[nextGroup++];
+            break;
+        case PARTITION_INDIVIDUALLY:
+            end = position + 1;
+            break;
+    }
+
+    const std::span<const std::shared_ptr<const Guest>> partition(guests.data() + position,
+                                                                  end - position);
+    position = end;
+    return partition;
+}
+
+void GuestPartitioner::groupConnectedGuests()
+{
+    // Guests sharing a page are joined through the first guest seen with it
+    DisjointSets components(guests.size());
+    firstGuestsOfPages.clear();
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        for (const int page : guests[guest]->pages) {
+            const auto [it, inserted] = firstGuestsOfPages.try_emplace(page, guest);
+            if (!inserted) {
+                components.unite(guest, it->second);
+            }
+        }
+    }
+
+    // Groups go in the order of their first guests, and guests in the order given, so each group
+    // is a contiguous run of the reordered guests
+    constexpr size_t noGroup = std::numeric_limits<size_t>::max();
+    groupOfRoots.assign(guests.size(), noGroup);
+    groupEnds.clear();
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        size_t &group = groupOfRoots[components.find(guest)];
+        if (group == noGroup) {
+            group = groupEnds.size();
+            groupEnds.push_back(0);
+        }
+        ++groupEnds[group];
+    }
+
+    // The counts become the starts of the groups, each of which is advanced past its group's
+    // guests to become its end
+    std::exclusive_scan(groupEnds.begin(), groupEnds.end(), groupEnds.begin(), size_t{ 0 });
+    groupedGuests.resize(guests.size());
+    for (size_t guest = 0; guest < guests.size(); ++guest) {
+        const size_t group = groupOfRoots[components.find(guest)];
+        groupedGuests[groupEnds[group]++] = std::move(guests[guest]);
+    }
+    guests.swap(groupedGuests);
+    grouped = true;
+}
+
+DecantingIndex::DecantingIndex(const std::vector<std::shared_ptr<Host>> &hosts)
+    : hosts(hosts), admitted(hosts.size())
+{
+    for (size_t host = 0; host < hosts.size(); ++host) {
+        for (const int page : hosts[host]->getPageFrequencies() | std::views::keys) {
+            pageHosts[page].insert(host);
+        }
+    }
+}
+
+size_t DecantingIndex::calculateResidual(const size_t host) const
+{
+    const size_t used = hosts[host]->getUniquePageCount();
+    const size_t capacity = hosts[host]->getCapacity();
+    return used < capacity ? capacity - used : 0;
+}
+
+std::optional<size_t> DecantingIndex::findTarget(const std::unordered_map<int, size_t> &pages,
+                                                 const size_t before, const size_t except) const
+{
+    size_t pageCount = 0;
+    std::unordered_map<size_t, size_t> sharedCounts;
+    for (const auto &[page, weight] : pages) {
+        pageCount += weight;
+        const auto it = pageHosts.find(page);
+        if (it == pageHosts.end()) {
+            continue;
+        }
+        size_t ranked = 0;
+        for (const size_t host : it->second) {
+            if (host >= before || ranked == DecantingIndex::MAX_RANKED_HOSTS_PER_PAGE) {
+                break;
+            }
+            if (admitted[host] && host != except) {
+                sharedCounts[host] += weight;
+                ++ranked;
+            }
+        }
+    }
+
+    // A host fits the pages if it has room for those it does not share
+    std::optional<size_t> best;
+    size_t bestShared = 0;
+    for (const auto &[host, shared] : sharedCounts) {
+        if (calculateResidual(host) + shared < pageCount) {
+            continue;
+        }
+        if (!best.has_value() || shared > bestShared || (shared == bestShared && host < *best)) {
+            best = host;
+            bestShared = shared;
+        }
+    }
+    if (best.has_value()) {
+        return best;
+    }
+
+    // No host sharing a page has room, so any host that has room for every page shares none.
+    // Hosts of equal residual are by index, so once one is not before `before`, none after it is,
+    // and the search skips to the next residual rather than passing every later host.
+    auto it = residuals.lower_bound({ pageCount, 0 });
+    while (it != residuals.end()) {
+        if (it->second == except) {
+            ++it;
+        }
+        else if (it->second < before) {
+            return it->second;
+        }
+        else {
+            it = residuals.lower_bound({ it->first + 1, 0 });
+        }
+    }
+    return std::nullopt;
+}
+
+void DecantingIndex::admitHost(const size_t host)
+{
+    if (admitted[host] || hosts[host]->getGuests().empty()) {
+        return;
+    }
+    admitted[host] = true;
+    residuals.emplace(calculateResidual(host), host);
+}
+
+void DecantingIndex::moveGuest(const std::shared_ptr<const Guest> &guest, const size_t source,
+                               const size_t target)
+{
+    assert(admitted[target]);
+
+    residuals.erase({ calculateResidual(target), target });
+    residuals.erase({ calculateResidual(source), source });
+
+    hosts[target]->addGuest(guest);
+    hosts[source]->removeGuest(guest);
+
+    for (const int page : guest->pages) {
+        if (hosts[target]->getPageFrequency(page) == 1) {
+            pageHosts[page].insert(target);
+        }
+        if (hosts[source]->getPageFrequency(page) == 0) {
+            pageHosts[page].erase(source);
+        }
+    }
+
+    residuals.emplace(calculateResidual(target), target);
+    if (admitted[source] && !hosts[source]->getGuests().empty()) {
+        residuals.emplace(calculateResidual(source), source);
+    }
+}
+
+void decantGuests(std::vector<std::shared_ptr<Host>> &hosts, const GuestPartitioning partitioning)
+{
+    // The partitioner of each host, rewound rather than reset until guests are moved off it.
+    // Guests are only moved onto a host once it is on the left, after which it is never
+    // partitioned again.
+    std::vector<GuestPartitioner> partitioners(hosts.size(), GuestPartitioner(partitioning));
+    std::vector<bool> partitionersAreStale(hosts.size(), true);
+
+    for (size_t left = 0; left < hosts.size(); ++left) {
+        const auto &leftHost = hosts[left];
+
+        for (size_t right = left + 1; right < hosts.size(); ++right) {
+            const auto &rightHost = hosts[right];
+            auto &partitioner = partitioners[right];
+
+            if (partitionersAreStale[right]) {
+                const auto &rightGuests = rightHost->getGuests();
+                partitioner.reset(rightGuests.begin(), rightGuests.end());
+                partitionersAreStale[right] = false;
+            } else {
+                partitioner.rewind();
+            }
+
+            while (const auto partition = partitioner.next()) {
+                if (leftHost->screenGuests(partition->begin(), partition->end()) ==
+                        SCREENING_OVERFULL ||
+                    !leftHost->accommodatesGuests(partition->begin(), partition->end())) {
+                    continue;
+                }
+
+                for (const auto &guest : *partition) {
+                    leftHost->addGuest(guest);
+                    rightHost->removeGuest(guest);
+                }
+                partitionersAreStale[right] = true;
+            }
+        }
+    }
+    std::erase_if(hosts, [](const auto &host) { return host->getGuests().empty(); });
+}
+
+/*
+ * The unique pages of a partition of guests, each with its weight
+ */
+static std::unordered_map<int, size_t>
+findUniquePages(const std::span<const std::shared_ptr<const Guest>> guests)
+{
+    std::unordered_map<int, size_t> uniquePages;
+    for (const auto &guest : guests) {
+        for (const int page : guest->pages) {
+            uniquePages.try_emplace(page, guest->getPageWeight(page));
+        }
+    }
+    return uniquePages;
+}
+
+void decantGuestsByIndex(std::vector<std::shared_ptr<Host>> &hosts,
+                         const GuestPartitioning partitioning)
+{
+    DecantingIndex index(hosts);
+    GuestPartitioner partitioner(partitioning);
+
+    for (size_t source = 0; source < hosts.size(); ++source) {
+        const auto &sourceGuests = hosts[source]->getGuests();
+        partitioner.reset(sourceGuests.begin(), sourceGuests.end());
+
+        while (const auto partition = partitioner.next()) {
+            const auto target = index.findTarget(findUniquePages(*partition), source);
+            if (!target.has_value()) {
+                continue;
+            }
+
+            for (const auto &guest : *partition) {
+                index.moveGuest(guest, source, *target);
+            }
+        }
+
+        // Guests only move to earlier hosts, as in `decantGuests`
+        index.admitHost(source);
+    }
+    std::erase_if(hosts, [](const auto &host) { return host->getGuests().empty(); });
+}
+
+void decantGuestByAllPartitioners(std::vector<std::shared_ptr<Host>> &hosts, const bool byIndex)
+{
+    const auto decant = byIndex ? decantGuestsByIndex : decantGuests;
+    decant(hosts, PARTITION_ALL_TOGETHER);
+    decant(hosts, PARTITION_CONNECTED_TOGETHER);
+    decant(hosts, PARTITION_INDIVIDUALLY);
+}
+
+void decantGuestsToFixpoint(std::vector<std::shared_ptr<Host>> &hosts, const size_t maxRounds)
+{
+    constexpr size_t partitionerCount = 3;
+    std::array<GuestPartitioner, partitionerCount> partitioners = {
+        GuestPartitioner(PARTITION_ALL_TOGETHER), GuestPartitioner(PARTITION_CONNECTED_TOGETHER),
+        GuestPartitioner(PARTITION_INDIVIDUALLY)
+    };
+
+    DecantingIndex index(hosts);
+    std::vector<size_t> worklist(hosts.size());
+    for (size_t host = 0; host < hosts.size(); ++host) {
+        index.admitHost(host);
+        worklist[host] = host;
+    }
+
+    // When each host was last affected for and last tried by each partitioner, by a common clock,
+    // and how many partitions each partitioner made of it then
+    size_t clock = 1;
+    std::vector<std::array<size_t, partitionerCount>> affectedAt(hosts.size(), { 1, 1, 1 });
+    std::vector<std::array<size_t, partitionerCount>> triedAt(hosts.size());
+    std::vector<std::array<size_t, partitionerCount>> partitionCounts(hosts.size());
+    const auto triedSinceAffected = [&](const size_t host, const size_t partitioner) {
+        return triedAt[host][partitioner] > affectedAt[host][partitioner];
+    };
+
+    // The hosts affected this round, in the order first affected, sorted at the end of the round
+    std::vector<size_t> nextWorklist;
+    std::vector<bool> queued(hosts.size());
+    const auto affect = [&](const size_t host, const size_t lastPartitioner) {
+        ++clock;
+        for (size_t partitioner = 0; partitioner <= lastPartitioner; ++partitioner) {
+            affectedAt[host][partitioner] = clock;
+        }
+        if (!queued[host]) {
+            queued[host] = true;
+            nextWorklist.push_back(host);
+        }
+    };
+
+    // The hosts that gave up guests this round and still hold some
+    std::vector<size_t> shedSources;
+
+    for (size_t round = 0; round < maxRounds && !worklist.empty(); ++round) {
+        for (size_t partitioner = 0; partitioner < partitionerCount; ++partitioner) {
+            for (const size_t source : worklist) {
+                const auto &sourceGuests = hosts[source]->getGuests();
+                if (sourceGuests.empty() || triedSinceAffected(source, partitioner)) {
+                    continue;
+                }
+                triedAt[source][partitioner] = ++clock;
+                partitionCounts[source][partitioner] = 0;
+                const size_t guestCount = sourceGuests.size();
+                bool moved = false;
+
+                partitioners[partitioner].reset(sourceGuests.begin(), sourceGuests.end());
+                while (const auto partition = partitioners[partitioner].next()) {
+                    ++partitionCounts[source][partitioner];
+
+                    // A partition that a coarser partitioner has made since the host was last
+                    // affected would find no target again. Such a partition is the whole host, or
+                    // a guest when every guest was a set of connected guests of its own.
+                    const bool repeatsWholeHost =
+                        partitioner != PARTITION_ALL_TOGETHER && partition->size() == guestCount &&
+                        triedSinceAffected(source, PARTITION_ALL_TOGETHER);
+                    const bool repeatsConnected =
+                        partitioner == PARTITION_INDIVIDUALLY &&
+                        triedSinceAffected(source, PARTITION_CONNECTED_TOGETHER) &&
+                        partitionCounts[source][PARTITION_CONNECTED_TOGETHER] == guestCount;
+                    if (repeatsWholeHost || repeatsConnected) {
+                        continue;
+                    }
+
+                    const auto pages = findUniquePages(*partition);
+                    auto target = index.findTarget(pages, source);
+                    if (!target.has_value() && partition->size() == sourceGuests.size()) {
+                        target = index.findTarget(pages, hosts.size(), source);
+                    }
+                    if (!target.has_value()) {
+                        continue;
+                    }
+                    for (const auto &guest : *partition) {
+                        index.moveGuest(guest, source, *target);
+                    }
+                    moved = true;
+                }
+
+                if (!moved || sourceGuests.empty()) {
+                    continue;
+                }
+
+                // The source's whole host and sets of connected guests have changed, though each
+                // guest left is as it was. It also has room for more of the guests of the hosts
+                // after it, and for more whole hosts before it: those sharing its pages now, and
+                // those small enough once the round ends.
+                affect(source, PARTITION_CONNECTED_TOGETHER);
+                shedSources.push_back(source);
+                const auto sourcePages = hosts[source]->getPageFrequencies() | std::views::keys;
+                for (const size_t host : index.findHostsSharingPages(sourcePages)) {
+                    if (host > source) {
+                        affect(host, PARTITION_INDIVIDUALLY);
+                    }
+                    else if (host < source) {
+                        affect(host, PARTITION_ALL_TOGETHER);
+                    }
+                }
+            }
+        }
+
+        // Guests sharing no page with a host that gave up guests fit it if they are no larger
+        // than its room. So every host after such a host with a guest that small is retried, and
+        // every host before it that small as a whole.
+        std::ranges::sort(shedSources);
+        const auto findRoom = [&](const size_t shedSource) {
+            const auto &shedHost = hosts[shedSource];
+            return shedHost->getCapacity() -
+                   std::min(shedHost->getCapacity(), shedHost->getUniquePageCount());
+        };
+        size_t room = 0;
+        auto shed = shedSources.begin();
+        for (size_t host = 0; host < hosts.size(); ++host) {
+            for (; shed != shedSources.end() && *shed < host; ++shed) {
+                room = std::max(room, findRoom(*shed));
+            }
+            if (shed != shedSources.begin() &&
+                std::ranges::any_of(hosts[host]->getGuests(), [&](const auto &guest) {
+                    return guest->getUniquePageCount() <= room;
+                })) {
+                affect(host, PARTITION_INDIVIDUALLY);
+            }
+        }
+        room = 0;
+        auto laterShed = shedSources.rbegin();
+        for (size_t host = hosts.size(); host-- > 0;) {
+            for (; laterShed != shedSources.rend() && *laterShed > host; ++laterShed) {
+                room = std::max(room, findRoom(*laterShed));
+            }
+            if (laterShed != shedSources.rbegin() && !hosts[host]->getGuests().empty() &&
+                hosts[host]->getUniquePageCount() <= room) {
+                affect(host, PARTITION_ALL_TOGETHER);
+            }
+        }
+        shedSources.clear();
+
+        std::erase_if(nextWorklist, [&](const size_t host) {
+            queued[host] = false;
+            return std::ranges::all_of(std::views::iota(size_t{ 0 }, partitionerCount),
+                                       [&](const size_t partitioner) {
+                                           return triedSinceAffected(host, partitioner);
+                                       });
+        });
+        std::ranges::sort(nextWorklist);
+        worklist = std::move(nextWorklist);
+        nextWorklist.clear();
+    }
+    std::erase_if(hosts, [](const auto &host) { return host->getGuests().empty(); });
+}
+
 std::unordered_map<size_t, TreeLowerBounds>
 calculateAllSubtreeLowerBounds(const TreeInstance &instance)
 {
-    std::unordered_map<size_t, TreeLowerBounds> res;
+    const FrozenTreeInstance frozenInstance(instance);
+    const auto nodesTopDown = frozenInstance.getNodesTopDown();
 
     // The capacity of each of those hosts (as we go deeper down the tree, we
     // subtract from this capacity measurement to reflect that the nodes we've
     // visited must have been packed)
-    std::unordered_map<size_t, size_t> capacities;
-
-    // For later bottom-up traversal
-    std::unordered_map<size_t, size_t> unvisitedChildCounts;
-
-    std::queue<size_t> bottomUpNodesToVisit;
-    std::queue<size_t> topDownNodesToVisit;
+    std::vector<size_t> capacities(frozenInstance.getNodeCount());
+    std::vector<TreeLowerBounds> bounds(frozenInstance.getNodeCount(), TreeLowerBounds(0, 0));
 
     // To calculate capacities we must go top-down
-    const size_t root = TreeInstance::getRootNode();
-    topDownNodesToVisit.push(root);
-    capacities[root] = instance.getCapacity();
+    capacities[TreeInstance::getRootNode()] = frozenInstance.getCapacity();
+    for (const size_t node : nodesTopDown) {
+        const size_t weight = frozenInstance.getNodePages(node).size();
+        for (const size_t child : frozenInstance.getNodeChildren(node)) {
+            capacities[child] = capacities[node] - weight;
+        }
+    }
 
-    while (!topDownNodesToVisit.empty()) {
-        const size_t node = topDownNodesToVisit.front();
-        topDownNodesToVisit.pop();
+    // To calculate size and count we must go bottom-up
+    std::unordered_map<size_t, TreeLowerBounds> res;
+    for (const size_t node : std::views::reverse(nodesTopDown)) {
+        const size_t weight = frozenInstance.getNodePages(node).size();
+        const auto children = frozenInstance.getNodeChildren(node);
 
-        const size_t weight = instance.getNodePages(node).size();
+        if (children.empty()) {
+            bounds[node] = TreeLowerBounds(weight, 1);
+            res.emplace(node, bounds[node]);
+            continue;
+        }
 
-        const auto &children = instance.getNodeChildren(node);
+        size_t childrenTotalSize = 0;
         for (const size_t child : children) {
-            capacities[child] = capacities[node] - weight;
-            topDownNodesToVisit.push(child);
+            childrenTotalSize += bounds[child].size;
         }
-        if ((unvisitedChildCounts[node] = children.size()) == 0) {
-            bottomUpNodesToVisit.push(node);
+
+        const size_t count = std::ceil(static_cast<double>(childrenTotalSize) /
+                                       static_cast<double>(capacities[node] - weight));
+        bounds[node] = TreeLowerBounds(childrenTotalSize + count * weight, count);
+        res.emplace(node, bounds[node]);
+    }
+
+    return res;
+}
+
+TreeLowerBoundsTracker::TreeLowerBoundsTracker(TreeInstance &instance)
+    : instance(instance),
+      frozenInstance(instance),
+      bounds(instance.getNodeCount(), TreeLowerBounds(0, 0)),
+      capacities(instance.getNodeCount()),
+      liveChildCounts(instance.getNodeCount()),
+      removed(instance.getNodeCount())
+{
+    const auto nodesTopDown = frozenInstance.getNodesTopDown();
+
+    // Nodes already removed from the instance are not in the frozen form, so count as removed
+    for (size_t node = 0; node < frozenInstance.getNodeCount(); ++node) {
+        removed[node] = !frozenInstance.nodeExists(node);
+        liveChildCounts[node] = frozenInstance.getNodeChildren(node).size();
+    }
+
+    // Capacities go top-down, and bounds bottom-up
+    capacities[TreeInstance::getRootNode()] = frozenInstance.getCapacity();
+    for (const size_t node : nodesTopDown) {
+        const size_t weight = frozenInstance.getNodePages(node).size();
+        for (const size_t child : frozenInstance.getNodeChildren(node)) {
+            capacities[child] = capacities[node] - weight;
         }
     }
 
-    // To calculate size and count we must go bottom-up
-    while (!bottomUpNodesToVisit.empty()) {
-        const size_t node = bottomUpNodesToVisit.front();
-        bottomUpNodesToVisit.pop();
+    for (const size_t node : std::views::reverse(nodesTopDown)) {
+        bounds[node] = calculateBounds(node);
+        pushIfPackable(node);
+    }
+}
 
-        const size_t parent = instance.getNodeParent(node);
-        if (node != root && --unvisitedChildCounts[parent] == 0) {
-            bottomUpNodesToVisit.push(parent);
+const TreeLowerBounds &TreeLowerBoundsTracker::getBounds(const size_t node) const
+{
+    return bounds[node];
+}
+
+TreeLowerBounds TreeLowerBoundsTracker::calculateBounds(const size_t node) const
+{
+    const size_t weight = frozenInstance.getNodePages(node).size();
+
+    // A node whose children have all been removed is now a leaf
+    if (liveChildCounts[node] == 0) {
+        return { weight, 1 };
+    }
+
+    size_t childrenTotalSize = 0;
+    for (const size_t child : frozenInstance.getNodeChildren(node)) {
+        if (!removed[child]) {
+            childrenTotalSize += bounds[child].size;
         }
+    }
 
-        const size_t weight = instance.getNodePages(node).size();
+    const size_t count = std::ceil(static_cast<double>(childrenTotalSize) /
+                                   static_cast<double>(capacities[node] - weight));
+    return { childrenTotalSize + count * weight, count };
+}
 
-        if (instance.nodeIsLeaf(node)) {
-            res.emplace(node, TreeLowerBounds(weight, 1));
-            continue;
+bool TreeLowerBoundsTracker::isPackable(const size_t node) const
+{
+    return !removed[node] && bounds[node].count > 1 &&
+           std::ranges::all_of(frozenInstance.getNodeChildren(node), [&](const size_t child) {
+               return removed[child] || bounds[child].count <= 1;
+           });
+}
+
+void TreeLowerBoundsTracker::pushIfPackable(const size_t node)
+{
+    if (isPackable(node)) {
+        packableNodes.emplace(bounds[node].count, node);
+    }
+}
+
+std::optional<size_t> TreeLowerBoundsTracker::findMinimalPackableNode()
+{
+    while (!packableNodes.empty()) {
+        const auto [count, node] = packableNodes.top();
+        if (count == bounds[node].count && isPackable(node)) {
+            return node;
         }
+        packableNodes.pop();
+    }
+    return std::nullopt;
+}
 
-        size_t childrenTotalSize = 0;
-        for (const size_t child : instance.getNodeChildren(node)) {
-            childrenTotalSize += res.at(child).size;
+std::vector<size_t> TreeLowerBoundsTracker::takePackableNodes()
+{
+    // Every entry is popped once, whether stale, a duplicate of a node, or taken
+    std::vector<size_t> nodes;
+    while (!packableNodes.empty()) {
+        const auto [count, node] = packableNodes.top();
+        packableNodes.pop();
+
+        if (count == bounds[node].count && isPackable(node) &&
+            (nodes.empty() || nodes.back() != node)) {
+            nodes.push_back(node);
         }
+    }
+    return nodes;
+}
 
-        const size_t count = std::ceil(static_cast<double>(childrenTotalSize) /
-                                       static_cast<double>(capacities[node] - weight));
-        const size_t size = childrenTotalSize + count * weight;
+void TreeLowerBoundsTracker::removeSubtree(const size_t root)
+{
+    assert(root != TreeInstance::getRootNode());
 
-        res.emplace(node, TreeLowerBounds(size, count));
+    std::vector<size_t> subtree{ root };
+    for (size_t i = 0; i < subtree.size(); ++i) {
+        removed[subtree[i]] = true;
+        for (const size_t child : frozenInstance.getNodeChildren(subtree[i])) {
+            if (!removed[child]) {
+                subtree.push_back(child);
+            }
+        }
     }
 
-    return res;
+    size_t node = frozenInstance.getNodeParent(root);
+    --liveChildCounts[node];
+    instance.removeSubtree(root);
+
+    // The parent has lost a child, so may have become packable even if its bounds are unchanged.
+    // Further up, nothing changes once a node's bounds do not.
+    while (true) {
+        const TreeLowerBounds newBounds = calculateBounds(node);
+        const bool changed =
+            newBounds.size != bounds[node].size || newBounds.count != bounds[node].count;
+
+        bounds[node] = newBounds;
+        pushIfPackable(node);
+
+        if (node == TreeInstance::getRootNode() || !changed) {
+            break;
+        }
+        node = frozenInstance.getNodeParent(node);
+    }
 }
 
 }  // namespace vmp
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <vmp_threadpool.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace vmp
+{
+
+// The pool and queue index of the worker running on this thread, if any
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local size_t currentQueue = 0;
+
+WorkStealingPool::WorkStealingPool(const size_t threadCount)
+    : queuedCount(0), pendingCount(0), nextExternalQueue(0), stopping(false)
+{
+    const size_t workerCount = std::max<size_t>(threadCount, 1);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        threads.emplace_back([this, i] { work(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard lock(stateMutex);
+        stopping = true;
+    }
+    taskQueued.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    // Spread tasks from outside the pool over the workers, so that they need not all be stolen
+    const size_t queue = currentPool == this
+                             ? currentQueue
+                             : nextExternalQueue.fetch_add(1) % threads.size();
+
+    pendingCount.fetch_add(1);
+    {
+        std::lock_guard lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    queuedCount.fetch_add(1);
+
+    {
+        // Taking the lock orders this notification after any worker's check of `queuedCount`
+        std::lock_guard lock(stateMutex);
+    }
+    taskQueued.notify_one();
+}
+
+bool WorkStealingPool::tryRunTask(const size_t self)
+{
+    std::function<void()> task;
+
+    // Own tasks first, newest first, as they are most likely to be in cache. A thread outside the
+    // pool, passed as `queues.size()`, has none.
+    if (self < queues.size()) {
+        std::lock_guard lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty()) {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+        }
+    }
+
+    // Then steal the oldest task from the other queues
+    for (size_t offset = 1; !task && offset <= queues.size(); ++offset) {
+        const size_t victimIndex = (self + offset) % queues.size();
+        if (victimIndex == self) {
+            continue;
+        }
+        TaskQueue &victim = *queues[victimIndex];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+    queuedCount.fetch_sub(1);
+
+    try {
+        task();
+    }
+    catch (...) {
+        std::lock_guard lock(stateMutex);
+        if (!firstError) {
+            firstError = std::current_exception();
+        }
+    }
+
+    if (pendingCount.fetch_sub(1) == 1) {
+        std::lock_guard lock(stateMutex);
+        allDone.notify_all();
+    }
+    return true;
+}
+
+void WorkStealingPool::work(const size_t self)
+{
+    currentPool = this;
+    currentQueue = self;
+
+    while (true) {
+        if (tryRunTask(self)) {
+            continue;
+        }
+
+        std::unique_lock lock(stateMutex);
+        taskQueued.wait(lock, [&] { return stopping || queuedCount.load() > 0; });
+        if (stopping && queuedCount.load() == 0) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::wait()
+{
+    // A thread outside the pool has no queue of its own, so it helps out by stealing only
+    const size_t self = currentPool == this ? currentQueue : queues.size();
+
+    while (pendingCount.load() > 0) {
+        if (tryRunTask(self)) {
+            continue;
+        }
+
+        std::unique_lock lock(stateMutex);
+        allDone.wait(lock, [&] { return pendingCount.load() == 0 || queuedCount.load() > 0; });
+    }
+
+    std::lock_guard lock(stateMutex);
+    if (firstError) {
+        std::rethrow_exception(std::exchange(firstError, nullptr));
+    }
+}
+
+size_t WorkStealingPool::getThreadCount() const
+{
+    return threads.size();
+}
+
+}  // namespace vmp
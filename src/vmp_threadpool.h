@@ -0,0 +1,73 @@
+#ifndef VMP_THREADPOOL_H
+#define VMP_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vmp
+{
+
+/**
+ * A fixed pool of worker threads, each with its own task deque. A worker runs its own tasks
+ * newest-first, and steals the oldest tasks of other workers when it runs out. Tasks may submit
+ * further tasks, which go to the submitting worker's own deque.
+ */
+class WorkStealingPool
+{
+  public:
+    explicit WorkStealingPool(size_t threadCount);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * Schedule a task on the pool
+     *
+     * @param task the task to run
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Block until every task submitted so far, and every task those submit, has finished. The
+     * calling thread runs tasks while it waits. Rethrows the first exception thrown by a task.
+     */
+    void wait();
+
+    [[nodiscard]] size_t getThreadCount() const;
+
+  private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool tryRunTask(size_t self);
+    void work(size_t self);
+
+    // One deque per worker. Tasks submitted from outside the pool are spread over them.
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<size_t> queuedCount;   // tasks sitting in a deque
+    std::atomic<size_t> pendingCount;  // tasks submitted but not yet finished
+    std::atomic<size_t> nextExternalQueue;
+    bool stopping;
+
+    std::mutex stateMutex;
+    std::condition_variable taskQueued;
+    std::condition_variable allDone;
+    std::exception_ptr firstError;
+};
+
+}  // namespace vmp
+
+#endif  // VMP_THREADPOOL_H
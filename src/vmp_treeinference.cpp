@@ -0,0 +1,230 @@
+#include <vmp_treeinference.h>
+
+#include <vmp_minhash.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stack>
+#include <tuple>
+
+namespace vmp
+{
+
+constexpr size_t NO_CLUSTER = std::numeric_limits<size_t>::max();
+constexpr size_t NO_GUEST = std::numeric_limits<size_t>::max();
+
+/* A cluster of guests: the pages common to all of them, sorted, and either the guest of a leaf or
+ * the clusters merged into it*/
+struct GuestCluster
+{
+    std::vector<int> sharedPages;
+    std::vector<size_t> children;
+    size_t guest;
+};
+
+static size_t countCommonPages(const std::vector<int> &pages1, const std::vector<int> &pages2)
+{
+    size_t common = 0;
+    auto it1 = pages1.begin();
+    auto it2 = pages2.begin();
+    while (it1 != pages1.end() && it2 != pages2.end()) {
+        if (*it1 < *it2) {
+            ++it1;
+        }
+        else if (*it2 < *it1) {
+            ++it2;
+        }
+        else {
+            ++common;
+            ++it1;
+            ++it2;
+        }
+    }
+    return common;
+}
+
+/* Orders the guests by their MinHash signatures, lexicographically, so that guests which share
+ * their least-hashed pages are next to each other*/
+static std::vector<size_t> orderGuestsBySignature(
+    const std::vector<std::shared_ptr<const Guest>> &guests, const size_t signatureSize,
+    const uint64_t seed)
+{
+    const MinHasher hasher(signatureSize, seed);
+    std::vector<uint64_t> signatures(guests.size() * signatureSize);
+    for (size_t i = 0; i < guests.size(); ++i) {
+        hasher.sign(guests[i]->pages,
+                    std::span(signatures).subspan(i * signatureSize, signatureSize));
+    }
+
+    std::vector<size_t> order(guests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, [&](const size_t guest1, const size_t guest2) {
+        return std::lexicographical_compare(
+            signatures.begin() + guest1 * signatureSize,
+            signatures.begin() + (guest1 + 1) * signatureSize,
+            signatures.begin() + guest2 * signatureSize,
+            signatures.begin() + (guest2 + 1) * signatureSize);
+    });
+    return order;
+}
+
+/* Adds `child` to the children of `parent`, or its children instead if it holds no more pages*/
+static void adoptCluster(std::vector<GuestCluster> &clusters, const size_t parent,
+                         const size_t child)
+{
+    GuestCluster &childCluster = clusters[child];
+    if (childCluster.guest == NO_GUEST &&
+        childCluster.sharedPages.size() == clusters[parent].sharedPages.size()) {
+        std::ranges::move(childCluster.children, std::back_inserter(clusters[parent].children));
+        childCluster.children.clear();
+        return;
+    }
+    clusters[parent].children.push_back(child);
+}
+
+TreeInstance inferTreeInstance(const GeneralInstance &instance, const size_t signatureSize,
+                               const uint64_t seed)
+{
+    const auto &guests = instance.getGuests();
+    const size_t guestCount = guests.size();
+
+    // Clusters are never removed, so a merged cluster is at a new index
+    std::vector<GuestCluster> clusters;
+    clusters.reserve(2 * guestCount + 1);
+
+    std::vector<size_t> previous;
+    std::vector<size_t> next;
+    std::vector<bool> merged;
+
+    for (const size_t guest : orderGuestsBySignature(guests, signatureSize, seed)) {
+        std::vector<int> pages(guests[guest]->pages.begin(), guests[guest]->pages.end());
+        std::ranges::sort(pages);
+
+        previous.push_back(clusters.empty() ? NO_CLUSTER : clusters.size() - 1);
+        next.push_back(NO_CLUSTER);
+        if (!clusters.empty()) {
+            next[clusters.size() - 1] = clusters.size();
+        }
+        merged.push_back(false);
+        clusters.push_back({ std::move(pages), {}, guest });
+    }
+
+    // Adjacent pairs by the Jaccard similarity of their shared pages, most similar first, then
+    // leftmost first, for which the left index is kept flipped. Entries go stale as their clusters
+    // are merged.
+    std::priority_queue<std::tuple<double, size_t, size_t>> pairs;
+    auto pushPair = [&](const size_t left, const size_t right) {
+        if (left == NO_CLUSTER || right == NO_CLUSTER) {
+            return;
+        }
+
+        const auto &leftPages = clusters[left].sharedPages;
+        const auto &rightPages = clusters[right].sharedPages;
+        const size_t common = countCommonPages(leftPages, rightPages);
+        if (common == 0) {
+            return;
+        }
+
+        const size_t unionSize = leftPages.size() + rightPages.size() - common;
+        pairs.emplace(static_cast<double>(common) / static_cast<double>(unionSize),
+                      NO_CLUSTER - left, right);
+    };
+
+    for (size_t cluster = 0; cluster + 1 < clusters.size(); ++cluster) {
+        pushPair(cluster, cluster + 1);
+    }
+
+    size_t first = clusters.empty() ? NO_CLUSTER : 0;
+    while (!pairs.empty()) {
+        const auto [similarity, flippedLeft, right] = pairs.top();
+        pairs.pop();
+
+        const size_t left = NO_CLUSTER - flippedLeft;
+        if (merged[left] || merged[right]) {
+            continue;
+        }
+
+        const size_t parent = clusters.size();
+        std::vector<int> sharedPages;
+        std::ranges::set_intersection(clusters[left].sharedPages, clusters[right].sharedPages,
+                                      std::back_inserter(sharedPages));
+        clusters.push_back({ std::move(sharedPages), {}, NO_GUEST });
+        adoptCluster(clusters, parent, left);
+        adoptCluster(clusters, parent, right);
+
+        // The merged cluster takes the place of the pair in the order
+        merged[left] = merged[right] = true;
+        merged.push_back(false);
+        previous.push_back(previous[left]);
+        next.push_back(next[right]);
+        if (previous[left] != NO_CLUSTER) {
+            next[previous[left]] = parent;
+        }
+        else {
+            first = parent;
+        }
+        if (next[right] != NO_CLUSTER) {
+            previous[next[right]] = parent;
+        }
+
+        pushPair(previous[parent], parent);
+        pushPair(parent, next[parent]);
+    }
+
+    // The clusters left share no pages with their neighbours, so hang them all from the root,
+    // which holds the pages common to all of them
+    size_t root = first;
+    if (first == NO_CLUSTER || next[first] != NO_CLUSTER || clusters[first].guest != NO_GUEST) {
+        root = clusters.size();
+        clusters.push_back({ {}, {}, NO_GUEST });
+
+        for (size_t cluster = first; cluster != NO_CLUSTER; cluster = next[cluster]) {
+            if (cluster == first) {
+                clusters[root].sharedPages = clusters[cluster].sharedPages;
+            }
+            else {
+                std::vector<int> sharedPages;
+                std::ranges::set_intersection(clusters[root].sharedPages,
+                                              clusters[cluster].sharedPages,
+                                              std::back_inserter(sharedPages));
+                clusters[root].sharedPages = std::move(sharedPages);
+            }
+        }
+        for (size_t cluster = first; cluster != NO_CLUSTER; cluster = next[cluster]) {
+            adoptCluster(clusters, root, cluster);
+        }
+    }
+
+    const auto &rootPages = clusters[root].sharedPages;
+    TreeInstance tree(instance.getCapacity(),
+                      std::unordered_set<int>(rootPages.begin(), rootPages.end()));
+
+    // Each node holds the pages shared by its cluster but not by its parent's
+    std::stack<std::pair<size_t, size_t>> clustersToAdd;
+    clustersToAdd.emplace(root, TreeInstance::getRootNode());
+
+    while (!clustersToAdd.empty()) {
+        const auto [cluster, node] = clustersToAdd.top();
+        clustersToAdd.pop();
+
+        for (const size_t child : clusters[cluster].children) {
+            std::unordered_set<int> pages;
+            std::ranges::set_difference(clusters[child].sharedPages,
+                                        clusters[cluster].sharedPages,
+                                        std::inserter(pages, pages.end()));
+
+            if (clusters[child].guest != NO_GUEST) {
+                tree.addLeaf(node, guests[clusters[child].guest], pages);
+            }
+            else {
+                clustersToAdd.emplace(child, tree.addInner(node, pages));
+            }
+        }
+    }
+
+    return tree;
+}
+
+}  // namespace vmp
@@ -0,0 +1,37 @@
+#ifndef VMP_TREEINFERENCE_H
+#define VMP_TREEINFERENCE_H
+
+#include <vmp_generalinstance.h>
+#include <vmp_treeinstance.h>
+
+namespace vmp
+{
+
+/**
+ * Infers a tree instance from a general instance by agglomerative clustering on shared pages, so
+ * that the tree solvers and orderings can run on flat page sets.
+ *
+ * The guests are first ordered by their MinHash signatures, which puts guests with similar page
+ * sets next to each other. Then, as in single-linkage clustering restricted to that order, the
+ * adjacent pair of clusters whose common pages have the greatest Jaccard similarity is merged
+ * until no adjacent pair has a page in common. Each cluster becomes a node holding the pages
+ * common to all its guests that its parent does not hold, and a cluster that holds no more pages
+ * than one it absorbed takes over that one's children instead, which keeps the tree shallow.
+ *
+ * Every guest's pages are exactly the union of the pages on its path from the root. A page shared
+ * by guests in different subtrees, but not by all of their common ancestor's guests, appears in
+ * each subtree, which the tree model counts once per subtree, so the tree's lower bounds are then
+ * a heuristic. Packings of the tree remain valid for the general instance, as hosts count the
+ * guests' own pages.
+ *
+ * @param instance the instance to infer a tree for
+ * @param signatureSize the number of hash functions in each MinHash signature. Defaults to 32.
+ * @param seed the seed of the hash functions. Defaults to 0.
+ * @return a tree instance with the same capacity, whose leaves are the instance's guests
+ */
+TreeInstance inferTreeInstance(const GeneralInstance &instance, size_t signatureSize = 32,
+                               uint64_t seed = 0);
+
+}  // namespace vmp
+
+#endif  // VMP_TREEINFERENCE_H
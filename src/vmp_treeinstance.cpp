@@ -1,51 +1,101 @@
 #include <vmp_treeinstance.h>
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <stack>
 
 namespace vmp
 {
 
 TreeInstance::TreeInstance(const size_t capacity, const std::unordered_set<int> &rootPages)
-    : capacity(capacity)
+    : tourIsStale(true), guestsAreStale(true), capacity(capacity)
 {
     nodes = std::vector<std::optional<Node>>(ROOT_NODE + 1);
-    nodes[ROOT_NODE] =
-        Node(ROOT_NODE, rootPages, std::unordered_set<std::shared_ptr<const Guest>>{});
+    nodes[ROOT_NODE] = Node(ROOT_NODE, rootPages, nullptr);
 }
 
 TreeInstance::TreeInstance(const size_t capacity, const std::unordered_set<int> &rootPages,
                            const std::shared_ptr<const Guest> &rootGuest)
-    : capacity(capacity)
+    : tourIsStale(true), guestsAreStale(true), capacity(capacity)
 {
     nodes = std::vector<std::optional<Node>>(ROOT_NODE + 1);
-    nodes[ROOT_NODE] = Node(ROOT_NODE, rootPages, std::unordered_set{ rootGuest });
+    nodes[ROOT_NODE] = Node(ROOT_NODE, rootPages, rootGuest);
 }
 
 size_t TreeInstance::addInner(const size_t parent, const std::unordered_set<int> &pages)
 {
     const size_t newNode = nodes.size();
-    nodes.push_back(std::make_optional<Node>(parent, pages,
-                                             std::unordered_set<std::shared_ptr<const Guest>>{}));
+    nodes.push_back(std::make_optional<Node>(parent, pages, nullptr));
     nodes[parent]->children.push_back(newNode);
+
+    tourIsStale = true;
     return newNode;
 }
 
-size_t TreeInstance::addLeaf(size_t parent, const std::shared_ptr<const Guest> &guest,
+size_t TreeInstance::addLeaf(const size_t parent, const std::shared_ptr<const Guest> &guest,
                              const std::unordered_set<int> &pages)
 {
     const size_t newNode = nodes.size();
-    nodes.push_back(std::make_optional<Node>(parent, pages, std::unordered_set{ guest }));
+    nodes.push_back(std::make_optional<Node>(parent, pages, guest));
     leaves.push_back(newNode);
     nodes[parent]->children.push_back(newNode);
 
-    while (parent != ROOT_NODE) {
-        nodes[parent]->guests.insert(guest);
-        parent = nodes[parent]->parent;
+    tourIsStale = true;
+    guestsAreStale = true;
+    return newNode;
+}
+
+void TreeInstance::makeTourIfStale() const
+{
+    if (!tourIsStale) {
+        return;
     }
-    nodes[ROOT_NODE]->guests.insert(guest);
 
-    return newNode;
+    tourGuests.clear();
+
+    // Depth-first, noting where each subtree's leaves begin on the way down and end on the way up
+    std::stack<std::pair<size_t, size_t>> path;
+    path.emplace(ROOT_NODE, 0);
+    nodes[ROOT_NODE]->tourBegin = 0;
+    if (nodes[ROOT_NODE]->guest) {
+        tourGuests.push_back(nodes[ROOT_NODE]->guest);
+    }
+
+    while (!path.empty()) {
+        auto &[node, nextChild] = path.top();
+        const auto &children = nodes[node]->children;
+
+        if (nextChild == children.size()) {
+            nodes[node]->tourEnd = tourGuests.size();
+            path.pop();
+            continue;
+        }
+
+        const size_t child = children[nextChild++];
+        nodes[child]->tourBegin = tourGuests.size();
+        if (nodes[child]->guest) {
+            tourGuests.push_back(nodes[child]->guest);
+        }
+        path.emplace(child, 0);
+    }
+
+    tourIsStale = false;
+}
+
+void TreeInstance::makeGuestsIfStale() const
+{
+    if (!guestsAreStale) {
+        return;
+    }
+
+    makeTourIfStale();
+
+    guests.clear();
+    std::ranges::copy_if(tourGuests, std::back_inserter(guests),
+                         [](const auto &guest) { return guest != nullptr; });
+
+    guestsAreStale = false;
 }
 
 const std::vector<size_t> &TreeInstance::getNodeChildren(const size_t node) const
@@ -65,14 +115,17 @@ const std::unordered_set<int> &TreeInstance::getNodePages(const size_t node) con
 
 std::shared_ptr<const Guest> TreeInstance::getNodeGuest(const size_t node) const
 {
-    assert(nodes[node]->guests.size() == 1);
-    return *nodes[node]->guests.begin();
+    assert(nodes[node]->guest != nullptr);
+    return nodes[node]->guest;
 }
 
-const std::unordered_set<std::shared_ptr<const Guest>> &
+std::span<const std::shared_ptr<const Guest>>
 TreeInstance::getSubtreeGuests(const size_t root) const
 {
-    return nodes[root]->guests;
+    makeTourIfStale();
+
+    const Node &node = *nodes[root];
+    return std::span(tourGuests).subspan(node.tourBegin, node.tourEnd - node.tourBegin);
 }
 
 bool TreeInstance::nodeIsLeaf(const size_t node) const
@@ -90,9 +143,10 @@ size_t TreeInstance::getCapacity() const
     return capacity;
 }
 
-const std::unordered_set<std::shared_ptr<const Guest>> &TreeInstance::getGuests() const
+const std::vector<std::shared_ptr<const Guest>> &TreeInstance::getGuests() const
 {
-    return nodes[ROOT_NODE]->guests;
+    makeGuestsIfStale();
+    return guests;
 }
 
 const std::vector<size_t> &TreeInstance::getLeaves() const
@@ -102,13 +156,21 @@ const std::vector<size_t> &TreeInstance::getLeaves() const
 
 void TreeInstance::removeSubtree(const size_t root)
 {
-    const auto &guestsToRemove = nodes[root]->guests;
-    for (int node = 0; node < nodes.size(); ++node) {
-        if (node == root || !nodes[node].has_value()) {
-            continue;
-        }
-        for (const auto &guest : guestsToRemove) {
-            nodes[node]->guests.erase(guest);
+    makeTourIfStale();
+
+    // The subtree's leaves are contiguous in the tour, so blank them there rather than search
+    const Node &rootNode = *nodes[root];
+    for (size_t i = rootNode.tourBegin; i < rootNode.tourEnd; ++i) {
+        tourGuests[i] = nullptr;
+    }
+    guestsAreStale = true;
+
+    // Only the parent still refers to the subtree
+    if (root != ROOT_NODE) {
+        auto &parentChildren = nodes[rootNode.parent]->children;
+        const auto it = std::ranges::find(parentChildren, root);
+        if (it != parentChildren.end()) {
+            parentChildren.erase(it);
         }
     }
 
@@ -122,14 +184,6 @@ void TreeInstance::removeSubtree(const size_t root)
         for (size_t child : nodes[node]->children) {
             nodesToRemove.push(child);
         }
-
-        const size_t parent = nodes[node]->parent;
-        auto &parentChildren = nodes[parent]->children;
-        const auto it = std::ranges::find(parentChildren, node);
-        if (it != parentChildren.end()) {
-            parentChildren.erase(it);
-        }
-
         nodes[node].reset();
     }
 }
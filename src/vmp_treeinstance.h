@@ -4,6 +4,7 @@
 #include <vmp_guest.h>
 
 #include <queue>
+#include <span>
 #include <unordered_set>
 #include <vector>
 
@@ -23,12 +24,38 @@ class TreeInstance
     [[nodiscard]] size_t getNodeParent(size_t node) const;
     [[nodiscard]] const std::unordered_set<int> &getNodePages(size_t node) const;
     [[nodiscard]] std::shared_ptr<const Guest> getNodeGuest(size_t node) const;
-    [[nodiscard]] const std::unordered_set<std::shared_ptr<const Guest>> &
+
+    /**
+     * The guests of the leaves under `root`, which are contiguous in the Euler tour of the tree.
+     * Guests of leaves removed since the tour was made are left in the range as `nullptr`.
+     *
+     * The first call after nodes are added makes the tour, so it is not thread-safe: threads
+     * sharing an instance must not call it until it has been called once since the last change.
+     *
+     * @param root the root of the subtree
+     * @return the guests of the subtree, valid until the tree is next changed
+     */
+    [[nodiscard]] std::span<const std::shared_ptr<const Guest>>
     getSubtreeGuests(size_t root) const;
     [[nodiscard]] bool nodeIsLeaf(size_t node) const;
     [[nodiscard]] size_t getNodeCount() const;
     [[nodiscard]] size_t getCapacity() const;
-    [[nodiscard]] const std::unordered_set<std::shared_ptr<const Guest>> &getGuests() const;
+
+    /**
+     * The guests of the leaves still in the tree, in depth-first order, so that guests which share
+     * an ancestor's pages are next to each other
+     *
+     * The order is fixed by the tree, where it used to follow the hashes of the guests' addresses,
+     * so the order-sensitive solvers now give the same packing on every run, though not always a
+     * better one: `solveByOverloadAndRemove` packs the tree of examples/basic_example.cpp into 3
+     * hosts where the hash order happened to give 2.
+     *
+     * The first call after the tree changes makes the guests, so it is not thread-safe: threads
+     * sharing an instance must not call it until it has been called once since the last change.
+     *
+     * @return the guests, valid until the tree is next changed
+     */
+    [[nodiscard]] const std::vector<std::shared_ptr<const Guest>> &getGuests() const;
     [[nodiscard]] const std::vector<size_t> &getLeaves() const;
     void removeSubtree(size_t root);
 
@@ -48,21 +75,38 @@ class TreeInstance
         // If it's a leaf, the pages unique to the node
         std::unordered_set<int> pages;
 
-        // This is a useful and reasonably expensive cache to keep at each node
-        std::unordered_set<std::shared_ptr<const Guest>> guests;
+        // The guest, if it's a leaf
+        std::shared_ptr<const Guest> guest;
+
+        // The range of the subtree's leaves in the Euler tour, set whenever the tour is made
+        mutable size_t tourBegin;
+        mutable size_t tourEnd;
 
         Node(const size_t parent, const std::unordered_set<int> &pages,
-             const std::unordered_set<std::shared_ptr<const Guest>> &guests)
-            : parent(parent), pages(pages), guests(guests)
+             const std::shared_ptr<const Guest> &guest)
+            : parent(parent), pages(pages), guest(guest), tourBegin(0), tourEnd(0)
         {
         }
 
-        Node() : parent(0) {};
+        Node() : parent(0), tourBegin(0), tourEnd(0) {};
     };
 
+    void makeTourIfStale() const;
+    void makeGuestsIfStale() const;
+
     std::vector<std::optional<Node>> nodes;
     std::vector<size_t> leaves;
 
+    // The guests of the leaves in depth-first order, made on first use after the tree has grown.
+    // Removing a subtree only blanks its leaves' entries, so the tour stays valid. Making it from
+    // a const getter is why those getters are not thread-safe until it is made.
+    mutable std::vector<std::shared_ptr<const Guest>> tourGuests;
+    mutable bool tourIsStale;
+
+    // The tour without the blanked entries, made on first use after the tree has changed
+    mutable std::vector<std::shared_ptr<const Guest>> guests;
+    mutable bool guestsAreStale;
+
     const size_t capacity;
     static constexpr size_t ROOT_NODE = 0;
 };
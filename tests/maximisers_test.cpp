@@ -0,0 +1,128 @@
+#include <vmp_clustertreeinstance.h>
+#include <vmp_maximisers.h>
+
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+
+constexpr size_t capacity = 12;
+constexpr size_t clusterWidth = 17;
+constexpr int pagePool = 24;
+
+// One cluster of `clusterWidth` nodes under the root, each the only parent of one leaf
+struct WideCluster
+{
+    vmp::ClusterTreeInstance instance;
+    size_t root;
+    size_t cluster;
+
+    // The pages of each guest, as a bitset, which are its node's and one page of its own
+    std::vector<uint64_t> guestPages;
+
+    WideCluster()
+        : instance(capacity),
+          root(instance.addInner(vmp::ClusterTreeInstance::getRootCluster(), {}, {})),
+          cluster(instance.createCluster(vmp::ClusterTreeInstance::getRootCluster()))
+    {
+    }
+
+    void addNode(const std::unordered_set<int> &nodePages)
+    {
+        const size_t node = instance.addInner(cluster, { root }, nodePages);
+
+        const int ownPage = pagePool + static_cast<int>(guestPages.size());
+        std::unordered_set<int> pages = nodePages;
+        pages.insert(ownPage);
+        instance.addLeaf({ node }, std::make_shared<vmp::Guest>(pages), { ownPage });
+
+        uint64_t bits = 0;
+        for (const int page : pages) {
+            bits |= 1ULL << page;
+        }
+        guestPages.push_back(bits);
+    }
+};
+
+// Nodes draw their pages from a small pool, so they overlap
+WideCluster mkRandomCluster(const unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pageDist(0, pagePool - 1);
+    std::uniform_int_distribution<int> countDist(1, 3);
+
+    WideCluster wide;
+    for (size_t i = 0; i < clusterWidth; ++i) {
+        std::unordered_set<int> nodePages;
+        for (int k = countDist(rng); k > 0; --k) {
+            nodePages.insert(pageDist(rng));
+        }
+        wide.addNode(nodePages);
+    }
+    return wide;
+}
+
+// Ten nodes of one page each look cheapest one at a time, but at most six of their guests fit
+// together, while the seven guests of the nodes sharing the same five pages all fit
+WideCluster mkDecoyCluster()
+{
+    WideCluster wide;
+    for (int decoy = 0; decoy < 10; ++decoy) {
+        wide.addNode({ 5 + decoy });
+    }
+    while (wide.guestPages.size() < clusterWidth) {
+        wide.addNode({ 0, 1, 2, 3, 4 });
+    }
+    return wide;
+}
+
+// The most guests that fit on one host together, by trying every set of guests
+size_t findMostGuestsOnOneHost(const std::vector<uint64_t> &guestPages)
+{
+    size_t best = 0;
+    for (uint64_t set = 0; set < 1ULL << guestPages.size(); ++set) {
+        uint64_t pages = 0;
+        for (size_t guest = 0; guest < guestPages.size(); ++guest) {
+            if (set & 1ULL << guest) {
+                pages |= guestPages[guest];
+            }
+        }
+        if (static_cast<size_t>(std::popcount(pages)) <= capacity) {
+            best = std::max<size_t>(best, std::popcount(set));
+        }
+    }
+    return best;
+}
+
+int checkExact(const WideCluster &wide, const std::string &name)
+{
+    const size_t expected = findMostGuestsOnOneHost(wide.guestPages);
+
+    std::unordered_map<std::shared_ptr<const vmp::Guest>, int> profits;
+    for (const auto &guest : wide.instance.getGuests()) {
+        profits[guest] = 1;
+    }
+
+    int failures = 0;
+    for (const auto mode : { vmp::CLUSTER_TREE_DP_DENSE, vmp::CLUSTER_TREE_DP_FRONTIER }) {
+        const vmp::Host host = vmp::maximiseOneHostByClusterTree(wide.instance, profits, 1, mode);
+        if (host.getGuestCount() != expected || host.isOverfull()) {
+            std::cerr << name << ", mode " << mode << ": placed " << host.getGuestCount()
+                      << " guests where " << expected << " fit" << std::endl;
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+// A cluster of more than 16 nodes is still searched exactly, in both modes of the DP
+int main()
+{
+    int failures = checkExact(mkDecoyCluster(), "decoys");
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        failures += checkExact(mkRandomCluster(seed), "seed " + std::to_string(seed));
+    }
+
+    return failures == 0 ? 0 : 1;
+}
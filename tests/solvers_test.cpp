@@ -0,0 +1,67 @@
+#include <vmp_generalinstance.h>
+#include <vmp_solvers.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+
+constexpr size_t capacity = 1500;
+constexpr size_t guestCount = 600;
+constexpr int imageCount = 30;
+constexpr int imagePageCount = 300;
+constexpr int ownPageCount = 30;
+
+// Each guest holds most of the pages of one of a few shared images, and some pages of its own
+vmp::GeneralInstance mkImageInstance(const unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> imageDist(0, imageCount - 1);
+    std::uniform_int_distribution<int> keepDist(0, 9);
+
+    std::vector<std::shared_ptr<const vmp::Guest>> guests;
+    int nextOwnPage = imageCount * imagePageCount;
+    for (size_t guest = 0; guest < guestCount; ++guest) {
+        std::unordered_set<int> pages;
+        const int image = imageDist(rng);
+        for (int page = 0; page < imagePageCount; ++page) {
+            if (keepDist(rng) < 8) {
+                pages.insert(image * imagePageCount + page);
+            }
+        }
+        for (int page = 0; page < ownPageCount; ++page) {
+            pages.insert(nextOwnPage++);
+        }
+        guests.push_back(std::make_shared<vmp::Guest>(pages));
+    }
+    return vmp::GeneralInstance(capacity, guests);
+}
+
+// Scoring only the LSH candidates costs Best Fusion at most a few hosts in twenty
+int checkApproximateEfficiency(const unsigned seed)
+{
+    const vmp::GeneralInstance instance = mkImageInstance(seed);
+    const vmp::Packing exact = vmp::solveByEfficiency(instance);
+    const vmp::Packing approximate = vmp::solveByApproximateEfficiency(instance);
+
+    const std::string name = "seed " + std::to_string(seed);
+    if (approximate.validateForInstance(instance) != vmp::PACKING_OKAY) {
+        std::cerr << name << ": invalid packing" << std::endl;
+        return 1;
+    }
+    if (approximate.getHostCount() * 20 > exact.getHostCount() * 21) {
+        std::cerr << name << ": " << approximate.getHostCount() << " hosts where Best Fusion uses "
+                  << exact.getHostCount() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int failures = 0;
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        failures += checkApproximateEfficiency(seed);
+    }
+
+    return failures == 0 ? 0 : 1;
+}